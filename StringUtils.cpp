@@ -6,6 +6,11 @@
 #include "memory.h"
 #include <cstdarg>
 #include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace utils {
 
@@ -29,4 +34,38 @@ u32 string_format_v(char *dst, const char *format, va_list args) {
   return written;
 }
 
+u32 string_format_v(char *dst, u64 size, const char *format, va_list args) {
+  if (size == 0) { return 0; }
+  i32 written = vsnprintf(dst, size, format, args);
+  if (written < 0) {
+    dst[0] = 0;
+    return 0;
+  }
+  return (u64) written < size ? written : size - 1;
+}
+
+const char *find_char(const char *begin, const char *end, char c) {
+  const char *p = begin;
+#if defined(__SSE2__)
+  __m128i needle = _mm_set1_epi8(c);
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) p);
+    u32     mask  = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask) { return p + __builtin_ctz(mask); }
+  }
+#elif defined(__ARM_NEON)
+  uint8x16_t needle = vdupq_n_u8((u8) c);
+  for (; end - p >= 16; p += 16) {
+    uint8x16_t matches = vceqq_u8(vld1q_u8((const u8 *) p), needle);
+    // Narrow each 0x00/0xff byte to a nibble, NEON has no movemask
+    u64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    if (mask) { return p + (__builtin_ctzll(mask) >> 2); }
+  }
+#endif
+  for (; p < end; ++p) {
+    if (*p == c) { return p; }
+  }
+  return end;
+}
+
 } // namespace utils
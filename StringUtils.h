@@ -7,6 +7,12 @@
 #include "defines.h"
 #include <cstdio>
 
+// Non-owning, not necessarily terminated
+struct StringView {
+  const char *ptr;
+  u64         length;
+};
+
 namespace utils {
 
 u32 string_length(CString s);
@@ -14,4 +20,12 @@ u32 string_length(CString s);
 u32 string_format(char *dst, const char *format, ...);
 u32 string_format_v(char *dst, const char *format, va_list args);
 
+// Formats straight into `dst` without an intermediate copy. Output is truncated to `size - 1`
+// characters, returns the number of characters written.
+u32 string_format_v(char *dst, u64 size, const char *format, va_list args);
+
+// Returns the first `c` in [begin, end), or `end`. Scans 16 bytes at a time and never reads
+// outside the range, so it's safe on mapped memory.
+const char *find_char(const char *begin, const char *end, char c);
+
 } // namespace utils
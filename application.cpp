@@ -3,31 +3,84 @@
 //
 
 #include "application.h"
+#include "core/Assets.h"
 #include "core/Clock.h"
+#include "core/FixedTimestep.h"
+#include "core/FramePacer.h"
+#include "core/FrameStats.h"
+#include "core/InputActions.h"
+#include "core/Profiler.h"
 #include "event.h"
 #include "input.h"
 #include "logging.h"
 #include "memory.h"
 #include "memory/LinearAllocator.h"
 #include "platform.h"
+#include "platform/async_io.h"
+#include "platform/file_watcher.h"
+#include "platform/filesystem.h"
+#include "platform/perf_counters.h"
+#include "platform/timer.h"
 #include "renderer/frontend.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 struct ApplicationState {
   bool  isRunning   = false;
   bool  isSuspended = false;
+  bool  isFocused   = true;
+  bool  lateLatchInput;
   u16   width;
   u16   height;
   Clock clock;
   f64   lastTime;
 
+  FramePacer    framePacer;
+  FixedTimestep timestep;
+  u32           backgroundFrameRate;
+  u64           lastBackgroundFrame;
+
+  SceneState previousScene = {.cameraZ = -1.0f}; // As of the tick before the latest
+  SceneState scene         = {.cameraZ = -1.0f};
+
+  CString assetDirectory;
+  CString inputBindingsPath;
+  CString profilePath;
+  CString frameStatsPath;
+
+  u32     benchmarkFrames;
+  CString benchmarkReportPath;
+  f32     benchmarkBudgetMs;
+  u64     benchmarkFrameIndex;
+  u64     benchmarkStartTime;
+  u64     benchmarkEndTime;
+  u64     benchmarkStartAllocCount;
+
   LinearAllocator *systemsAllocator;
 
   u64   loggingSystemMemorySize;
   void *loggingSystemState;
+  u64   profilerMemorySize;
+  void *profilerState;
+  u64   perfCountersMemorySize;
+  void *perfCountersState;
+  u64   frameStatsMemorySize;
+  void *frameStatsState;
   u64   eventSystemMemorySize;
   void *eventSystemState;
   u64   inputSystemMemorySize;
   void *inputSystemState;
+  u64   inputRecorderMemorySize;
+  void *inputRecorderState;
+  u64   inputActionsMemorySize;
+  void *inputActionsState;
+  u64   asyncIoMemorySize;
+  void *asyncIoState;
+  u64   fileWatcherMemorySize;
+  void *fileWatcherState;
+  u64   assetSystemMemorySize;
+  void *assetSystemState;
   u64   platformSystemMemorySize;
   void *platformSystemState;
   u64   rendererSystemMemorySize;
@@ -36,9 +89,25 @@ struct ApplicationState {
 
 static ApplicationState *state = nullptr;
 
+static constexpr u32 PROFILE_FRAMES = 300; // Written out per capture
+
+// Bounds how late async IO completions and file changes are handled while minimized
+static constexpr u64 SUSPENDED_WAIT_NS = 100 * 1000 * 1000;
+
+// Per second of simulated time
+static constexpr f32 CAMERA_SPEED = 0.3f;
+static constexpr f32 SPIN_SPEED   = 0.6f;
+
+static constexpr u32 BENCHMARK_WARMUP_FRAMES = 60;
+static constexpr f64 BENCHMARK_DELTA_TIME    = 1.0 / 60; // Keeps the scene the same on every run
+
 bool initialize();
+bool idle_wait();
+void handle_actions();
 bool update(f32 deltaTime);
 bool render();
+bool benchmark_frame();
+i32  benchmark_finish();
 
 // Event handles
 bool application_on_event(EventCode           code,
@@ -47,20 +116,62 @@ bool application_on_event(EventCode           code,
                           const EventContext &context);
 bool application_on_key(EventCode code, void *sender, void *listener, const EventContext &context);
 bool applicationOnResize(EventCode code, void *sender, void *listener, const EventContext &context);
+bool application_on_file_changed(EventCode           code,
+                                 void               *sender,
+                                 void               *listener,
+                                 const EventContext &context);
+bool application_on_focus(EventCode           code,
+                          void               *sender,
+                          void               *listener,
+                          const EventContext &context);
 
 void application_create(const ApplicationConfig &config) {
   ASSERT(!state);
 
   memory_system_initialize();
 
-  state                   = new ApplicationState();
-  state->systemsAllocator = new LinearAllocator(64 * MiB);
+  state                      = new ApplicationState();
+  state->systemsAllocator    = new LinearAllocator(64 * MiB);
+  state->lateLatchInput      = config.lateLatchInput;
+  state->assetDirectory      = config.assetDirectory;
+  state->inputBindingsPath   = config.inputBindingsPath;
+  state->profilePath         = config.profilePath;
+  state->frameStatsPath      = config.frameStatsPath;
+  state->benchmarkFrames     = config.benchmarkFrames;
+  state->benchmarkReportPath = config.benchmarkReportPath;
+  state->benchmarkBudgetMs   = config.benchmarkBudgetMs;
+  state->backgroundFrameRate = config.backgroundFrameRate;
+  state->framePacer.set_target(config.benchmarkFrames ? 0 : config.targetFrameRate);
+  state->timestep.set_rate(config.tickRate, config.maxTicksPerFrame);
 
   // Initialize subsystems
 
   logging_system_initialize(&state->loggingSystemMemorySize, nullptr);
   state->loggingSystemState = state->systemsAllocator->alloc(state->loggingSystemMemorySize);
-  logging_system_initialize(&state->loggingSystemMemorySize, state->loggingSystemState);
+  logging_system_initialize(
+      &state->loggingSystemMemorySize, state->loggingSystemState, config.logging);
+
+  platform_timer_initialize(config.cycleCounterTimer);
+
+  ProfilerConfig profilerConfig = {.enabled = config.profilePath != nullptr};
+  profiler_initialize(&state->profilerMemorySize, nullptr);
+  state->profilerState = state->systemsAllocator->alloc(state->profilerMemorySize);
+  profiler_initialize(&state->profilerMemorySize, state->profilerState, profilerConfig);
+  profiler_set_thread_name("Main");
+
+  PerfCountersConfig perfCountersConfig = {
+      .enabled = config.perfCounters,
+      .zones   = config.perfCountersZones,
+  };
+  perf_counters_initialize(&state->perfCountersMemorySize, nullptr);
+  state->perfCountersState = state->systemsAllocator->alloc(state->perfCountersMemorySize);
+  perf_counters_initialize(
+      &state->perfCountersMemorySize, state->perfCountersState, perfCountersConfig);
+  perf_counters_attach_thread();
+
+  frame_stats_initialize(&state->frameStatsMemorySize, nullptr);
+  state->frameStatsState = state->systemsAllocator->alloc(state->frameStatsMemorySize);
+  frame_stats_initialize(&state->frameStatsMemorySize, state->frameStatsState);
 
   event_system_initialize(&state->eventSystemMemorySize, nullptr);
   state->eventSystemState = state->systemsAllocator->alloc(state->eventSystemMemorySize);
@@ -70,72 +181,140 @@ void application_create(const ApplicationConfig &config) {
   event_register(EventCode::KeyReleased, nullptr, application_on_key);
   event_register(EventCode::KeyPressed, nullptr, application_on_key);
   event_register(EventCode::WindowResized, nullptr, applicationOnResize);
+  event_register(EventCode::WindowFocused, nullptr, application_on_focus);
 
   input_system_initialize(&state->inputSystemMemorySize, nullptr);
   state->inputSystemState = state->systemsAllocator->alloc(state->inputSystemMemorySize);
   input_system_initialize(&state->inputSystemMemorySize, state->inputSystemState);
 
-  platform_system_startup(
-      &state->platformSystemMemorySize, nullptr, config.appName, config.width, config.height);
+  input_recorder_initialize(&state->inputRecorderMemorySize,
+                            nullptr,
+                            config.inputRecorderMode,
+                            config.inputRecordingPath);
+  state->inputRecorderState = state->systemsAllocator->alloc(state->inputRecorderMemorySize);
+  input_recorder_initialize(&state->inputRecorderMemorySize,
+                            state->inputRecorderState,
+                            config.inputRecorderMode,
+                            config.inputRecordingPath);
+
+  input_actions_initialize(&state->inputActionsMemorySize, nullptr, config.inputBindingsPath);
+  state->inputActionsState = state->systemsAllocator->alloc(state->inputActionsMemorySize);
+  input_actions_initialize(
+      &state->inputActionsMemorySize, state->inputActionsState, config.inputBindingsPath);
+
+  async_io_initialize(&state->asyncIoMemorySize, nullptr);
+  state->asyncIoState = state->systemsAllocator->alloc(state->asyncIoMemorySize);
+  async_io_initialize(&state->asyncIoMemorySize, state->asyncIoState);
+
+  file_watcher_initialize(&state->fileWatcherMemorySize, nullptr);
+  state->fileWatcherState = state->systemsAllocator->alloc(state->fileWatcherMemorySize);
+  file_watcher_initialize(&state->fileWatcherMemorySize, state->fileWatcherState);
+  bool hotReload = config.hotReload && file_watcher_add(config.assetDirectory);
+  if (hotReload) { event_register(EventCode::FileChanged, nullptr, application_on_file_changed); }
+
+  // The archive would shadow the loose files being edited
+  CString archivePath = config.hotReload ? nullptr : config.assetArchivePath;
+  asset_system_initialize(
+      &state->assetSystemMemorySize, nullptr, archivePath, config.assetDirectory);
+  state->assetSystemState = state->systemsAllocator->alloc(state->assetSystemMemorySize);
+  asset_system_initialize(
+      &state->assetSystemMemorySize, state->assetSystemState, archivePath, config.assetDirectory);
+
+  bool headless = config.benchmarkFrames > 0;
+  platform_system_startup(&state->platformSystemMemorySize,
+                          nullptr,
+                          config.appName,
+                          config.width,
+                          config.height,
+                          headless);
   state->platformSystemState = state->systemsAllocator->alloc(state->platformSystemMemorySize);
   platform_system_startup(&state->platformSystemMemorySize,
                           state->platformSystemState,
                           config.appName,
                           config.width,
-                          config.height);
+                          config.height,
+                          headless);
 
   u32 width = 0, height = 0;
   platform_get_framebuffer_size(width, height);
 
   renderer_system_initialize(
-      &state->rendererSystemMemorySize, nullptr, config.appName, width, height);
+      &state->rendererSystemMemorySize, nullptr, config.appName, width, height, hotReload);
   state->rendererSystemState = state->systemsAllocator->alloc(state->rendererSystemMemorySize);
-  renderer_system_initialize(
-      &state->rendererSystemMemorySize, state->rendererSystemState, config.appName, width, height);
+  renderer_system_initialize(&state->rendererSystemMemorySize,
+                             state->rendererSystemState,
+                             config.appName,
+                             width,
+                             height,
+                             hotReload);
 
   ASSERT(initialize());
 
-  LOG_DEBUG("Hello, Pokemoon.");
+  LOGC_DEBUG(Application, "Hello, Pokemoon.");
 }
 
-void application_run() {
+i32 application_run() {
   ASSERT(state);
 
   state->isRunning = true;
 
   state->clock.start();
   state->clock.tick();
-  state->lastTime              = state->clock.elapsed();
-  const f64 targetFrameSeconds = 1.0f / 60;
+  state->lastTime = state->clock.elapsed();
 
   while (state->isRunning) {
+    bool background = idle_wait();
+    u64  frameStart = platform_get_time_ns();
+    profiler_frame_mark();
     platform_poll_events();
+    async_io_poll(); // Completions are dispatched even while suspended
+    file_watcher_poll();
+    logging_poll();
     if (!state->isSuspended) {
+      frame_stats_begin_frame();
+      if (state->benchmarkFrames && !benchmark_frame()) {
+        state->isRunning = false;
+        break;
+      }
       state->clock.tick();
-      f64 currentTime    = state->clock.elapsed();
-      f64 deltaTime      = currentTime - state->lastTime;
-      state->lastTime    = currentTime;
-      f64 frameStartTime = platform_get_absolute_time();
-
-      if (!update((f32) deltaTime)) {
+      f64 currentTime = state->clock.elapsed();
+      // Close the frame's input. When replaying, the recorded frame time replaces the clock's
+      if (!input_recorder_sync_frame(currentTime)) {
         state->isRunning = false;
         break;
       }
+      f64 deltaTime   = currentTime - state->lastTime;
+      state->lastTime = currentTime;
+      if (state->benchmarkFrames) { deltaTime = BENCHMARK_DELTA_TIME; }
+
+      input_actions_update(); // All input of the frame is in, evaluate the bindings once
+      handle_actions();
+
+      // The simulation runs in fixed ticks however long the frame took, none if it was short
+      u32 ticks = state->timestep.advance(deltaTime);
+      for (u32 i = 0; i < ticks && state->isRunning; ++i) {
+        if (!update((f32) state->timestep.step())) { state->isRunning = false; }
+      }
+      if (!state->isRunning) { break; }
       if (!render()) {
         state->isRunning = false;
         break;
       }
 
-      RenderPacket renderPacket = {};
-      renderPacket.deltaTime    = (f32) deltaTime;
-      renderer_draw_frame(renderPacket);
-
-      f64 frameEndTime     = platform_get_absolute_time();
-      f64 frameElapsedTime = frameEndTime - frameStartTime;
-      if (f64 remaining = targetFrameSeconds - frameElapsedTime; remaining > 0) {
-        platform_sleep((u64) (remaining * 1000)); // If there is time left, give it back to the OS
+      RenderPacket renderPacket   = {};
+      renderPacket.deltaTime      = (f32) deltaTime;
+      renderPacket.alpha          = state->timestep.alpha();
+      renderPacket.previousScene  = state->previousScene;
+      renderPacket.scene          = state->scene;
+      renderPacket.lateLatchInput = state->lateLatchInput;
+      {
+        FrameStatsTimer frameStatsTimer(FrameMetric::Render);
+        renderer_draw_frame(renderPacket);
       }
 
+      frame_stats_add(FrameMetric::Cpu, platform_get_time_ns() - frameStart);
+      if (!background) { state->framePacer.wait(); } // Already throttled harder by idle_wait()
+
       // Input update/state copying should always be handled after any input should be recorded
       input_update();
     }
@@ -143,14 +322,53 @@ void application_run() {
 
   state->isRunning = false;
 
+  auto pacing = state->framePacer.stats();
+  LOGC_INFO(Application,
+            "Frame pacing at %u fps: %llu frames, interval %.3f ms (sd %.3f, min %.3f, max %.3f), "
+            "max lateness %.1f us, %llu missed",
+            state->framePacer.target(),
+            (unsigned long long) pacing.frames,
+            pacing.meanIntervalMs,
+            pacing.stdDevIntervalMs,
+            pacing.minIntervalMs,
+            pacing.maxIntervalMs,
+            pacing.maxLatenessUs,
+            (unsigned long long) pacing.missedFrames);
+
+  auto simulation = state->timestep.stats();
+  LOGC_INFO(Application,
+            "Simulation at %u Hz: %llu ticks over %llu frames, %llu frames over the catch-up "
+            "limit, %.1f ms dropped",
+            state->timestep.rate(),
+            (unsigned long long) simulation.ticks,
+            (unsigned long long) simulation.frames,
+            (unsigned long long) simulation.limitedFrames,
+            simulation.droppedMs);
+
+  frame_stats_log();
+  if (state->frameStatsPath) { frame_stats_write_csv(state->frameStatsPath); }
+  i32 exitStatus = state->benchmarkFrames ? benchmark_finish() : 0;
+  if (state->profilePath) { profiler_export_chrome_trace(state->profilePath, PROFILE_FRAMES); }
+
   renderer_system_shutdown();
   platform_system_shutdown();
+  asset_system_shutdown();
+  event_deregister(EventCode::FileChanged, nullptr, application_on_file_changed);
+  file_watcher_shutdown();
+  async_io_shutdown();
+  input_actions_shutdown();
+  input_recorder_shutdown();
   input_system_shutdown();
+  event_deregister(EventCode::WindowFocused, nullptr, application_on_focus);
   event_deregister(EventCode::WindowResized, nullptr, applicationOnResize);
   event_deregister(EventCode::KeyPressed, nullptr, application_on_key);
   event_deregister(EventCode::KeyReleased, nullptr, application_on_key);
   event_deregister(EventCode::ApplicationQuit, nullptr, application_on_event);
   event_system_shutdown();
+  frame_stats_shutdown();
+  perf_counters_detach_thread();
+  perf_counters_shutdown();
+  profiler_shutdown();
   logging_system_shutdown();
 
   delete state->systemsAllocator;
@@ -158,14 +376,176 @@ void application_run() {
 
   memory_system_shutdown();
 
-  LOG_INFO(memory_get_usage());
+  LOGC_INFO(Application, "%s", memory_get_usage());
+
+  return exitStatus;
 }
 
 bool initialize() { return true; }
 
-bool update(f32 deltaTime) { return true; }
+// Blocks on window events rather than spinning while minimized, and holds frames back to the
+// background rate while unfocused. Any event that changes either returns right away. Returns
+// whether the coming frame is a background one.
+bool idle_wait() {
+  if (state->isSuspended) {
+    platform_wait_events(SUSPENDED_WAIT_NS);
+    return false;
+  }
+  if (state->isFocused || state->backgroundFrameRate == 0) { return false; }
+
+  u64 deadline = state->lastBackgroundFrame + 1000000000ull / state->backgroundFrameRate;
+  for (u64 now = platform_get_time_ns(); now < deadline; now = platform_get_time_ns()) {
+    platform_wait_events(deadline - now);
+    if (state->isFocused || state->isSuspended || !state->isRunning) { break; }
+  }
+  state->lastBackgroundFrame = platform_get_time_ns();
+  frame_stats_skip_interval(); // Slow on purpose, not a frame time
+  return true;
+}
+
+// Once per frame, the actions' edges would be missed or repeated by a tick
+void handle_actions() {
+  if (input_action_released(InputAction::Quit)) {
+    event_fire(EventCode::ApplicationQuit, nullptr, {});
+  }
+  if (input_action_released(InputAction::MemoryReport)) {
+    LOGC_INFO(Application, "%s", memory_get_usage());
+    LOGC_INFO(Application, "Alloc count: %d", memory_get_alloc_count());
+    frame_stats_log();
+  }
+  if (input_action_released(InputAction::ProfileCapture) && state->profilePath) {
+    profiler_export_chrome_trace(state->profilePath, PROFILE_FRAMES);
+  }
+}
+
+// One simulation tick of `deltaTime`, always the fixed step
+bool update(f32 deltaTime) {
+  PROFILE_SCOPE("update");
+  FrameStatsTimer frameStatsTimer(FrameMetric::Update);
+  state->previousScene = state->scene;
+  state->scene.cameraZ -= CAMERA_SPEED * deltaTime;
+  state->scene.angle += SPIN_SPEED * deltaTime;
+  return true;
+}
+
+bool render() {
+  PROFILE_SCOPE("render");
+  return true;
+}
+
+// Starts measuring once warmed up, returns false when all frames have been measured
+bool benchmark_frame() {
+  u64 frame = state->benchmarkFrameIndex++;
+  if (frame == BENCHMARK_WARMUP_FRAMES) {
+    frame_stats_reset();
+    state->benchmarkStartTime       = platform_get_time_ns();
+    state->benchmarkStartAllocCount = memory_get_alloc_count();
+  }
+  if (frame < BENCHMARK_WARMUP_FRAMES + state->benchmarkFrames) { return true; }
+  state->benchmarkEndTime = platform_get_time_ns();
+  return false;
+}
 
-bool render() { return true; }
+// Writes the report, returns the exit status
+i32 benchmark_finish() {
+  bool completed = state->benchmarkFrameIndex > BENCHMARK_WARMUP_FRAMES + state->benchmarkFrames;
+  bool exact     = state->benchmarkFrames <= FRAME_STATS_WINDOW; // Else 0.1 ms histogram buckets
+  auto frame     = frame_stats_summary(FrameMetric::Frame, exact);
+  f32  budget    = state->benchmarkBudgetMs;
+  bool passed    = completed && (budget <= 0 || frame.p99Ms <= budget);
+
+  f64 seconds     = 0;
+  u64 allocations = 0;
+  if (completed) {
+    seconds     = (f64) (state->benchmarkEndTime - state->benchmarkStartTime) * 1e-9;
+    allocations = memory_get_alloc_count() - state->benchmarkStartAllocCount;
+  }
+  LOGC_INFO(Application,
+            "Benchmark %s: %u frames in %.3f s, frame p99 %.3f ms (budget %.3f), %llu allocations",
+            passed ? "passed" : "failed",
+            state->benchmarkFrames,
+            seconds,
+            frame.p99Ms,
+            budget,
+            (unsigned long long) allocations);
+  if (!state->benchmarkReportPath) { return passed ? 0 : 1; }
+
+  char report[16 * KiB];
+  u64  used   = 0;
+  auto append = [&](const char *format, auto... args) {
+    i32 n = snprintf(report + used, sizeof(report) - used, format, args...);
+    if (n > 0) { used = std::min<u64>(used + n, sizeof(report) - 1); }
+  };
+  append("{\n  \"frames\": %u,\n  \"warmupFrames\": %u,\n",
+         state->benchmarkFrames,
+         BENCHMARK_WARMUP_FRAMES);
+  append("  \"completed\": %s,\n  \"passed\": %s,\n",
+         completed ? "true" : "false",
+         passed ? "true" : "false");
+  append("  \"budgetP99Ms\": %.3f,\n  \"seconds\": %.6f,\n", budget, seconds);
+  append("  \"hitches\": %llu,\n  \"metrics\": {", (unsigned long long) frame_stats_hitches());
+  for (u8 i = 0; i < FRAME_METRIC_COUNT; ++i) {
+    auto summary = frame_stats_summary((FrameMetric) i, exact);
+    append("%s\n    \"%s\": {\"samples\": %llu, \"meanMs\": %.4f, \"p50Ms\": %.4f, "
+           "\"p95Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f}",
+           i == 0 ? "" : ",",
+           frame_stats_metric_name((FrameMetric) i),
+           (unsigned long long) summary.samples,
+           summary.meanMs,
+           summary.p50Ms,
+           summary.p95Ms,
+           summary.p99Ms,
+           summary.maxMs);
+  }
+  append("\n  },\n");
+  auto counters = frame_stats_counters(exact);
+  if (counters.samples) {
+    append("  \"counters\": {\"frames\": %llu, \"ipc\": %.4f, \"cacheMissesPerKilo\": %.4f, "
+           "\"branchMissesPerKilo\": %.4f, \"cyclesPerFrame\": %.0f, "
+           "\"instructionsPerFrame\": %.0f, \"zones\": {",
+           (unsigned long long) counters.samples,
+           counters.ipc,
+           counters.cacheMissesPerKilo,
+           counters.branchMissesPerKilo,
+           counters.cyclesPerSample,
+           counters.instructionsPerSample);
+    // Warmup included, zones aren't split by frame
+    FrameZoneCounterSummary zones[PERF_COUNTERS_MAX_ZONES];
+    u32 zoneCount = frame_stats_zone_counters(zones, PERF_COUNTERS_MAX_ZONES);
+    for (u32 i = 0; i < zoneCount; ++i) {
+      append("%s\n    \"%s\": {\"count\": %llu, \"ipc\": %.4f, \"cacheMissesPerKilo\": %.4f, "
+             "\"branchMissesPerKilo\": %.4f, \"cyclesPerCount\": %.0f}",
+             i == 0 ? "" : ",",
+             zones[i].name,
+             (unsigned long long) zones[i].summary.samples,
+             zones[i].summary.ipc,
+             zones[i].summary.cacheMissesPerKilo,
+             zones[i].summary.branchMissesPerKilo,
+             zones[i].summary.cyclesPerSample);
+    }
+    append("%s}},\n", zoneCount ? "\n  " : "");
+  }
+  append("  \"memory\": {\"allocations\": %llu, \"allocationsPerFrame\": %.3f, "
+         "\"allocatedBytes\": %llu, \"peakBytes\": %llu, \"peakResidentBytes\": %llu}\n}\n",
+         (unsigned long long) allocations,
+         (f64) allocations / state->benchmarkFrames,
+         (unsigned long long) memory_get_allocated(),
+         (unsigned long long) memory_get_peak(),
+         (unsigned long long) platform_get_peak_resident_memory());
+
+  FileHandle file;
+  u64        written = 0;
+  bool       wrote   = filesystem_open(state->benchmarkReportPath, FILE_MODE_WRITE, false, &file);
+  if (wrote) {
+    wrote = filesystem_write(&file, used, report, &written);
+    filesystem_close(&file);
+  }
+  if (!wrote) {
+    LOGC_ERROR(Application, "Failed to write '%s'", state->benchmarkReportPath);
+    return 1;
+  }
+  return passed ? 0 : 1;
+}
 
 void resize() {}
 
@@ -186,18 +566,10 @@ bool application_on_event(EventCode           code,
 bool application_on_key(EventCode code, void *sender, void *listener, const EventContext &context) {
   if (code == EventCode::KeyPressed) {
     auto key = context.u16[0];
-    LOG_DEBUG("Key %d pressed", key);
+    LOGC_DEBUG(Application, "Key %d pressed", key);
   } else if ((EventCode) code == EventCode::KeyReleased) {
     auto key = (Key) context.u16[0];
-    if (key == Key::ESC) {
-      event_fire(EventCode::ApplicationQuit, nullptr, {});
-      return true;
-    } else if (key == Key::M) {
-      LOG_INFO(memory_get_usage());
-      LOG_INFO("Alloc count: %d", memory_get_alloc_count());
-      return true;
-    }
-    LOG_DEBUG("Key %d released", key);
+    LOGC_DEBUG(Application, "Key %d released", key);
   }
   return false;
 }
@@ -214,14 +586,54 @@ bool applicationOnResize(EventCode           code,
 
   if (width == 0 || height == 0) { // Handle minimization
     state->isSuspended = true;
+    frame_stats_skip_interval();
     return true;
   }
 
-  if (state->isSuspended) { state->isSuspended = false; } // Resume
+  if (state->isSuspended) { // Resume
+    state->isSuspended = false;
+    // The time spent minimized is neither a frame to pace against nor one to simulate
+    state->framePacer.restart();
+    state->clock.tick();
+    state->lastTime = state->clock.elapsed();
+  }
 
-  // LOG_DEBUG("Window resized: %i, %i", width, height);
+  // LOGC_DEBUG(Application, "Window resized: %i, %i", width, height);
 
   rendererOnResize(width, height);
 
   return false; // Event purposely not handled to allow other listeners to get this
 }
+
+bool application_on_file_changed(EventCode           code,
+                                 void               *sender,
+                                 void               *listener,
+                                 const EventContext &context) {
+  if (!state->inputBindingsPath) { return false; }
+  char path[512];
+  CString changed = file_watcher_get_path(context.u32[0]);
+  snprintf(path, sizeof(path), "%s/%s", state->assetDirectory, changed);
+  if (strcmp(path, state->inputBindingsPath) == 0) {
+    if (input_actions_load(path)) {
+      LOGC_INFO(Application, "Reloaded input bindings from '%s'", path);
+    } else {
+      LOGC_WARN(Application, "Failed to reload input bindings from '%s'", path);
+    }
+  }
+  return false;
+}
+
+bool application_on_focus(EventCode           code,
+                          void               *sender,
+                          void               *listener,
+                          const EventContext &context) {
+  bool focused = context.u8[0];
+  if (focused && !state->isFocused) {
+    // Back from the background rate, pick the target rate up from here
+    state->framePacer.restart();
+    frame_stats_skip_interval();
+  }
+  state->isFocused = focused;
+  LOGC_DEBUG(Application, "Window %s", focused ? "focused" : "unfocused");
+  return false;
+}
@@ -5,16 +5,51 @@
 #ifndef POKEMOON_APPLICATION_H
 #define POKEMOON_APPLICATION_H
 
+#include "core/InputRecorder.h"
 #include "defines.h"
+#include "logging.h"
 
 struct ApplicationConfig {
   CString appName;
   u16     width;
   u16     height;
+  u32     targetFrameRate;     // 0 for unlimited
+  u32     backgroundFrameRate; // While unfocused, 0 to keep the target
+  // Simulation ticks per second, independent of the frame rate. A slow frame is caught up with at
+  // most `maxTicksPerFrame` ticks, past that the simulation falls behind real time.
+  u32     tickRate;
+  u32     maxTicksPerFrame;
+
+  LoggingConfig logging;
+  bool          cycleCounterTimer; // Time with the calibrated TSC rather than clock_gettime
+  // Enables the profiler, the recent frames are written there as a Chrome trace on the
+  // ProfileCapture action and at exit
+  CString profilePath;
+  CString frameStatsPath; // Frame time percentiles are written there as CSV at exit
+  // Linux hardware counters per frame, logged with the frame stats. Zones adds them per
+  // PROFILE_SCOPE zone, which works without the profiler.
+  bool    perfCounters;
+  bool    perfCountersZones;
+
+  // Renders this many frames after a warmup, headless, unpaced and with a fixed time step, then
+  // exits. The report is written as JSON, the run fails if the frame time p99 exceeds the budget.
+  u32     benchmarkFrames;
+  CString benchmarkReportPath;
+  f32     benchmarkBudgetMs; // 0 for none
+
+  InputRecorderMode inputRecorderMode;
+  CString           inputRecordingPath;
+  bool              lateLatchInput;
+  CString           inputBindingsPath; // Falls back to the builtin bindings if not set
+
+  CString assetArchivePath; // Optional, packed with pokemoon_asset_packer
+  CString assetDirectory;   // Loose assets, used for anything not in the archive
+  bool    hotReload;        // Watch the loose assets and reload shaders and bindings on change
 };
 
 void application_create(const ApplicationConfig &config);
 
-void application_run();
+// Returns the process exit status
+i32 application_run();
 
 #endif // POKEMOON_APPLICATION_H
@@ -0,0 +1,204 @@
+//
+// Created by Hongjian Zhu on 2022/11/6.
+//
+
+// Runs the registered microbenchmarks.
+// Usage: pokemoon_bench [--filter <substring>] [--runs N] [--warmup N] [--min-time ms]
+//                       [--json <path>]
+//
+// Each benchmark first doubles its iteration count until a call takes at least --min-time, then
+// makes --warmup unmeasured and --runs measured calls. Times are reported per operation.
+
+#include "bench/Bench.h"
+#include "event.h"
+#include "logging.h"
+#include "memory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static constexpr u32 BENCH_MAX_COUNT = 64;
+
+struct Benchmark {
+  CString       name;
+  BenchFunction function;
+};
+
+struct BenchResult {
+  CString name;
+  u64     iterations; // Per run
+  u32     runs;
+  f64     meanNs;
+  f64     stdDevNs;
+  f64     minNs;
+  f64     medianNs;
+  f64     maxNs;
+};
+
+static Benchmark benchmarks[BENCH_MAX_COUNT];
+static u32       benchmarkCount = 0;
+
+void bench_register(CString name, BenchFunction function) {
+  if (benchmarkCount == BENCH_MAX_COUNT) {
+    fprintf(stderr, "Too many benchmarks, '%s' is skipped\n", name);
+    return;
+  }
+  benchmarks[benchmarkCount++] = {name, function};
+}
+
+// Nanoseconds per operation of one call
+static f64 measure(BenchFunction function, u64 iterations) {
+  BenchRun run(iterations);
+  u64      start   = platform_get_time_ns();
+  function(run);
+  u64      elapsed = platform_get_time_ns() - start - run.paused_ns();
+  return (f64) elapsed / (f64) iterations;
+}
+
+static BenchResult run_benchmark(const Benchmark &benchmark, u32 warmup, u32 runs, f64 minTimeNs) {
+  u64 iterations = 1;
+  for (;;) {
+    f64 total = measure(benchmark.function, iterations) * (f64) iterations;
+    if (total >= minTimeNs || iterations >= (1ull << 40)) { break; }
+    // Aim a little past the minimum, but grow at most 100x so a noisy short call can't overshoot
+    f64 scale  = total > 0 ? minTimeNs / total * 1.2 : 100;
+    iterations = (u64) ((f64) iterations * std::clamp(scale, 2.0, 100.0));
+  }
+
+  for (u32 i = 0; i < warmup; ++i) {
+    measure(benchmark.function, iterations);
+  }
+  std::vector<f64> samples(runs);
+  for (u32 i = 0; i < runs; ++i) {
+    samples[i] = measure(benchmark.function, iterations);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  f64 mean = 0;
+  for (f64 sample : samples) {
+    mean += sample;
+  }
+  mean /= runs;
+  f64 variance = 0;
+  for (f64 sample : samples) {
+    variance += (sample - mean) * (sample - mean);
+  }
+  variance = runs > 1 ? variance / (runs - 1) : 0;
+
+  f64 median = runs % 2 ? samples[runs / 2] : (samples[runs / 2 - 1] + samples[runs / 2]) / 2;
+  return {
+      .name       = benchmark.name,
+      .iterations = iterations,
+      .runs       = runs,
+      .meanNs     = mean,
+      .stdDevNs   = std::sqrt(variance),
+      .minNs      = samples.front(),
+      .medianNs   = median,
+      .maxNs      = samples.back(),
+  };
+}
+
+static bool write_json(CString path, const std::vector<BenchResult> &results) {
+  FILE *file = fopen(path, "w");
+  if (!file) { return false; }
+  fprintf(file, "{\"benchmarks\":[");
+  for (u64 i = 0; i < results.size(); ++i) {
+    auto &result = results[i];
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"iterations\":%llu,\"runs\":%u,\"meanNs\":%.3f,"
+            "\"stdDevNs\":%.3f,\"minNs\":%.3f,\"medianNs\":%.3f,\"maxNs\":%.3f}",
+            i == 0 ? "" : ",",
+            result.name,
+            (unsigned long long) result.iterations,
+            result.runs,
+            result.meanNs,
+            result.stdDevNs,
+            result.minNs,
+            result.medianNs,
+            result.maxNs);
+  }
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
+
+int main(int argc, char **argv) {
+  CString filter    = nullptr;
+  CString jsonPath  = nullptr;
+  u32     runs      = 10;
+  u32     warmup    = 2;
+  f64     minTimeMs = 20;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      warmup = (u32) std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+      minTimeMs = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--filter <substring>] [--runs N] [--warmup N] [--min-time ms] "
+              "[--json <path>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  // What the game runs on, minus the window. Logs only go to the file so the output stays readable.
+  memory_system_initialize();
+  u64           loggingMemorySize = 0;
+  LoggingConfig loggingConfig     = {
+          .quiet = true,
+          .file  = {.path = "pokemoon_bench.log", .maxSize = 16 * MiB, .maxArchives = 1},
+  };
+  logging_system_initialize(&loggingMemorySize, nullptr);
+  void *loggingState = calloc(1, loggingMemorySize);
+  logging_system_initialize(&loggingMemorySize, loggingState, loggingConfig);
+  platform_timer_initialize(false);
+  u64 eventMemorySize = 0;
+  event_system_initialize(&eventMemorySize, nullptr);
+  void *eventState = calloc(1, eventMemorySize); // Expects zeroed memory
+  event_system_initialize(&eventMemorySize, eventState);
+
+  printf("%-32s %12s %12s %10s %12s %12s %12s\n",
+         "benchmark",
+         "iterations",
+         "mean ns/op",
+         "stddev %",
+         "median",
+         "min",
+         "max");
+  std::vector<BenchResult> results;
+  for (u32 i = 0; i < benchmarkCount; ++i) {
+    if (filter && !strstr(benchmarks[i].name, filter)) { continue; }
+    auto result = run_benchmark(benchmarks[i], warmup, runs, minTimeMs * 1e6);
+    printf("%-32s %12llu %12.2f %10.2f %12.2f %12.2f %12.2f\n",
+           result.name,
+           (unsigned long long) result.iterations,
+           result.meanNs,
+           result.meanNs > 0 ? result.stdDevNs / result.meanNs * 100 : 0,
+           result.medianNs,
+           result.minNs,
+           result.maxNs);
+    fflush(stdout);
+    results.push_back(result);
+  }
+
+  event_system_shutdown();
+  free(eventState);
+  logging_system_shutdown();
+  free(loggingState);
+  memory_system_shutdown();
+
+  if (jsonPath && !write_json(jsonPath, results)) {
+    fprintf(stderr, "Failed to write '%s'\n", jsonPath);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+//
+// Created by Hongjian Zhu on 2022/11/6.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "platform/timer.h"
+
+// Handed to a benchmark, which does `iterations()` operations per call
+class BenchRun {
+public:
+  explicit BenchRun(u64 iterations) : _iterations(iterations) {}
+
+  u64 iterations() const { return _iterations; }
+
+  // The time between pause() and resume() isn't measured, e.g. for setup and teardown
+  void pause() { _pauseStart = platform_get_time_ns(); }
+  void resume() { _pausedNs += platform_get_time_ns() - _pauseStart; }
+
+  u64 paused_ns() const { return _pausedNs; }
+
+private:
+  u64 _iterations;
+  u64 _pauseStart = 0;
+  u64 _pausedNs   = 0;
+};
+
+using BenchFunction = void (*)(BenchRun &run);
+
+void bench_register(CString name, BenchFunction function);
+
+// Keeps the compiler from dropping `value` and the work that produced it
+template <typename T> inline void bench_keep(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchRegistrar {
+  BenchRegistrar(CString name, BenchFunction function) { bench_register(name, function); }
+};
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b)  BENCH_CONCAT_(a, b)
+
+// Registers `function` under `name`, e.g. BENCHMARK("event_fire/16", event_fire<16>)
+#define BENCHMARK(name, function)                                                                  \
+  static BenchRegistrar BENCH_CONCAT(benchRegistrar, __LINE__)(name, function)
@@ -0,0 +1,175 @@
+//
+// Created by Hongjian Zhu on 2022/11/6.
+//
+
+#include "StringUtils.h"
+#include "bench/Bench.h"
+#include "container/darray.h"
+#include "event.h"
+#include "logging.h"
+#include "memory.h"
+#include "memory/LinearAllocator.h"
+#include <cstdlib>
+
+static void darray_push(BenchRun &run) {
+  run.pause();
+  auto array = DARRAY_CREATE(u64);
+  run.resume();
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    DARRAY_PUSH(array, i);
+  }
+  bench_keep(array);
+  run.pause();
+  darray_destroy(array);
+  run.resume();
+}
+BENCHMARK("darray_push", darray_push);
+
+static u64 *create_filled(u64 length) {
+  auto array = DARRAY_RESERVE(u64, length + 1, MemoryTag::DArray);
+  for (u64 i = 0; i < length; ++i) {
+    DARRAY_PUSH(array, i);
+  }
+  return array;
+}
+
+// Into the middle of an array of `N`, the tail pop keeping the length is O(1)
+template <u64 N> static void darray_insert_at(BenchRun &run) {
+  run.pause();
+  auto array = create_filled(N);
+  run.resume();
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    DARRAY_INSERT_AT(array, N / 2, i);
+    darray_pop(array, nullptr);
+  }
+  bench_keep(array);
+  run.pause();
+  darray_destroy(array);
+  run.resume();
+}
+BENCHMARK("darray_insert_at/16", darray_insert_at<16>);
+BENCHMARK("darray_insert_at/1024", darray_insert_at<1024>);
+
+// From the middle of an array of `N`, the push back keeping the length is O(1)
+template <u64 N> static void darray_pop_at(BenchRun &run) {
+  run.pause();
+  auto array = create_filled(N);
+  run.resume();
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    u64 value = 0;
+    darray_pop_at(array, N / 2, &value);
+    DARRAY_PUSH(array, value);
+  }
+  bench_keep(array);
+  run.pause();
+  darray_destroy(array);
+  run.resume();
+}
+BENCHMARK("darray_pop_at/16", darray_pop_at<16>);
+BENCHMARK("darray_pop_at/1024", darray_pop_at<1024>);
+
+template <u64 Size> static void memory_allocate_free(BenchRun &run) {
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    void *block = memory_allocate(Size, MemoryTag::Array);
+    bench_keep(block);
+    memory_free(block, Size, MemoryTag::Array);
+  }
+}
+BENCHMARK("memory_allocate_free/64", memory_allocate_free<64>);
+BENCHMARK("memory_allocate_free/4096", memory_allocate_free<4096>);
+BENCHMARK("memory_allocate_free/1M", memory_allocate_free<1 * MiB>);
+
+// Reset zeroes the whole block, which is left out
+template <u64 Size> static void linear_allocator_alloc(BenchRun &run) {
+  static constexpr u64 CAPACITY = 1 * MiB;
+
+  run.pause();
+  auto allocator = new LinearAllocator(CAPACITY);
+  run.resume();
+  u64 left = CAPACITY / Size;
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    if (left-- == 0) {
+      run.pause();
+      allocator->reset();
+      left = CAPACITY / Size - 1;
+      run.resume();
+    }
+    bench_keep(allocator->alloc(Size));
+  }
+  run.pause();
+  delete allocator;
+  run.resume();
+}
+BENCHMARK("linear_allocator_alloc/16", linear_allocator_alloc<16>);
+BENCHMARK("linear_allocator_alloc/256", linear_allocator_alloc<256>);
+
+static bool on_event(EventCode, void *, void *listener, const EventContext &) {
+  bench_keep(listener);
+  return false; // Not handled, so every listener is called
+}
+
+template <u32 N> static void event_fire(BenchRun &run) {
+  static u8 listeners[N];
+
+  run.pause();
+  for (u32 i = 0; i < N; ++i) {
+    event_register(EventCode::Unknown, &listeners[i], on_event);
+  }
+  run.resume();
+  EventContext context = {};
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    context.u64[0] = i;
+    bench_keep(event_fire(EventCode::Unknown, nullptr, context));
+  }
+  run.pause();
+  for (u32 i = 0; i < N; ++i) {
+    event_deregister(EventCode::Unknown, &listeners[i], on_event);
+  }
+  run.resume();
+}
+BENCHMARK("event_fire/1", event_fire<1>);
+BENCHMARK("event_fire/16", event_fire<16>);
+BENCHMARK("event_fire/256", event_fire<256>);
+
+// Synchronous, formats and writes into the log file's buffer on the calling thread
+static void log_output_sync(BenchRun &run) {
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    log_output(LogLevel::Info, "Frame %llu took %.3f ms, %s", i, 16.667, "benchmark");
+  }
+}
+BENCHMARK("log_output/sync", log_output_sync);
+
+// Formats into the ring buffer, a writer thread does the rest
+static void log_output_async(BenchRun &run) {
+  static u64   memorySize = 0;
+  static void *state      = nullptr;
+
+  LoggingConfig config = {
+      .async = true,
+      .quiet = true,
+      .file  = {.path = "pokemoon_bench.log", .maxSize = 16 * MiB, .maxArchives = 1},
+  };
+  run.pause();
+  logging_system_shutdown();
+  logging_system_initialize(&memorySize, nullptr);
+  state = realloc(state, memorySize);
+  logging_system_initialize(&memorySize, state, config);
+  run.resume();
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    log_output(LogLevel::Info, "Frame %llu took %.3f ms, %s", i, 16.667, "benchmark");
+  }
+  run.pause();
+  logging_system_shutdown();
+  config.async = false;
+  logging_system_initialize(&memorySize, state, config);
+  run.resume();
+}
+BENCHMARK("log_output/async", log_output_async);
+
+static void string_format(BenchRun &run) {
+  char buffer[256];
+  for (u64 i = 0; i < run.iterations(); ++i) {
+    bench_keep(utils::string_format(buffer, "Frame %llu took %.3f ms, %s", i, 16.667, "benchmark"));
+  }
+}
+BENCHMARK("string_format", string_format);
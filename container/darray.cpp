@@ -4,6 +4,7 @@
 
 #include "darray.h"
 #include "logging.h"
+#include <cstring>
 
 void *darray_create(u64 capacity, u64 stride, MemoryTag tag) {
   u64  headerSize              = DArrayField::Max * sizeof(u64);
@@ -37,7 +38,8 @@ void darray_field_set(void *array, DArrayField field, u64 value) {
 void *darray_resize(void *array) {
   u64   length = darray_length(array);
   u64   stride = darray_stride(array);
-  void *darray = darray_create(DARRAY_RESIZE_FACTOR * darray_capacity(array), stride);
+  auto  tag    = (MemoryTag) darray_field_get(array, DArrayField::Tag);
+  void *darray = darray_create(DARRAY_RESIZE_FACTOR * darray_capacity(array), stride, tag);
   memory_copy(darray, array, length * stride);
   darray_length_set(darray, length);
   darray_destroy(array);
@@ -58,7 +60,7 @@ void *darray_push(void *array, const void *src) {
 void darray_pop(void *array, void *dst) {
   u64  length = darray_length(array);
   u64  stride = darray_stride(array);
-  auto src    = (u64 *) array;
+  auto src    = (u8 *) array;
   src += ((length - 1) * stride);
   if (dst) { memory_copy(dst, src, stride); }
   darray_length_set(array, length - 1);
@@ -68,15 +70,15 @@ void *darray_insert_at(void *array, u64 index, const void *src) {
   u64 length = darray_length(array);
   u64 stride = darray_stride(array);
   if (index >= length) {
-    LOG_ERROR("Index outside the bounds of the array. Length: %d, index: %d", length, index);
+    LOGC_ERROR(
+        Memory, "Index outside the bounds of the array. Length: %d, index: %d", length, index);
     return array;
   }
   if (length >= darray_capacity(array)) { array = darray_resize(array); }
 
-  auto dst = (u64 *) array;
-  if (index != length - 1) { // If not on the last element, copy the rest outward
-    memory_copy(dst + (index + 1) * stride, dst + index * stride, stride * (length - index));
-  }
+  auto dst = (u8 *) array;
+  // Move the element at `index` and the rest outward, the ranges overlap
+  memmove(dst + (index + 1) * stride, dst + index * stride, stride * (length - index));
   memory_copy(dst + index * stride, src, stride);
   darray_length_set(array, length + 1);
   return array;
@@ -86,18 +88,17 @@ void *darray_pop_at(void *array, u64 index, void *dst) {
   u64 length = darray_length(array);
   u64 stride = darray_stride(array);
   if (index >= length) {
-    LOG_ERROR("Index outside the bounds of the array. Length: %d, index: %d", length, index);
+    LOGC_ERROR(
+        Memory, "Index outside the bounds of the array. Length: %d, index: %d", length, index);
     return array;
   }
 
-  auto src = (u64) array;
-  if (dst) { memory_copy(dst, (void *) (src + index * stride), stride); }
+  auto src = (u8 *) array;
+  if (dst) { memory_copy(dst, src + index * stride, stride); }
 
   if (index != length - 1) {
-    // If not on the last element, snip out the entry and copy the reset inward
-    memory_copy((void *) (src + index * stride),
-                (void *) (src + (index - 1) * stride),
-                stride * (length - index));
+    // If not on the last element, snip out the entry and move the rest inward
+    memmove(src + index * stride, src + (index + 1) * stride, stride * (length - index - 1));
   }
   darray_length_set(array, length - 1);
   return array;
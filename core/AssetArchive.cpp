@@ -0,0 +1,156 @@
+//
+// Created by Hongjian Zhu on 2022/10/29.
+//
+
+#include "core/AssetArchive.h"
+#include "core/Compression.h"
+#include "core/ThreadPool.h"
+#include "logging.h"
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+bool asset_archive_open(CString path, AssetArchive *out) {
+  *out = {};
+  // Lookups jump around the table, the blobs are read front to back by their users
+  if (!filesystem_map(path, &out->view, FILE_MAP_RANDOM)) { return false; }
+
+  const auto &view   = out->view;
+  auto        header = (const AssetArchiveHeader *) view.data;
+  if (view.size < sizeof(AssetArchiveHeader) ||
+      memcmp(header->magic, ASSET_ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != ASSET_ARCHIVE_VERSION) {
+    LOGC_ERROR(Platform, "[AssetArchive] '%s' is not a compatible asset archive", path);
+    asset_archive_close(out);
+    return false;
+  }
+  u64 tableEnd = sizeof(AssetArchiveHeader) + header->tableSize * sizeof(AssetArchiveEntry);
+  if (header->tableSize == 0 || (header->tableSize & (header->tableSize - 1)) != 0 ||
+      tableEnd > view.size || header->namesOffset + header->namesSize > view.size ||
+      header->chunkSize == 0) {
+    LOGC_ERROR(Platform, "[AssetArchive] '%s' has a corrupted table of contents", path);
+    asset_archive_close(out);
+    return false;
+  }
+
+  out->header = header;
+  out->table  = (const AssetArchiveEntry *) (view.data + sizeof(AssetArchiveHeader));
+  out->names  = (const char *) view.data + header->namesOffset;
+  return true;
+}
+
+void asset_archive_close(AssetArchive *archive) {
+  filesystem_unmap(&archive->view);
+  *archive = {};
+}
+
+static bool entry_is_valid(const AssetArchive *archive, const AssetArchiveEntry &entry) {
+  if (entry.offset + entry.storedSize > archive->view.size) { return false; }
+  if (!(entry.flags & ASSET_ARCHIVE_ENTRY_COMPRESSED)) { return entry.storedSize == entry.size; }
+  u64 chunkSize = archive->header->chunkSize;
+  return entry.chunkCount == (entry.size + chunkSize - 1) / chunkSize &&
+         (u64) entry.chunkCount * sizeof(u32) <= entry.storedSize;
+}
+
+const AssetArchiveEntry *asset_archive_find(const AssetArchive *archive, CString name) {
+  u64 length = strlen(name);
+  u64 hash   = asset_archive_hash(name, length);
+  u32 mask   = archive->header->tableSize - 1;
+  u32 index  = (u32) hash & mask;
+  for (u32 probe = 0; probe <= mask; ++probe, index = (index + 1) & mask) {
+    const auto &entry = archive->table[index];
+    if (entry.hash == 0) { return nullptr; }
+    if (entry.hash != hash || entry.nameLength != length ||
+        memcmp(archive->names + entry.nameOffset, name, length) != 0) {
+      continue;
+    }
+    return entry_is_valid(archive, entry) ? &entry : nullptr;
+  }
+  return nullptr;
+}
+
+FileView asset_archive_stored(const AssetArchive *archive, const AssetArchiveEntry *entry) {
+  return {archive->view.data + entry->offset, entry->storedSize};
+}
+
+// Shared by the threads decompressing the chunks of one entry, which take them in order
+struct ChunkBatch {
+  const u8         *chunks;
+  const u32        *storedSizes;
+  const u64        *offsets; // Of each chunk from `chunks`
+  u8               *dst;
+  u64               size;
+  u32               chunkSize;
+  u32               chunkCount;
+  std::atomic<u32>  next{0};
+  std::atomic<u32>  exitedJobs{0};
+  std::atomic<bool> failed{false};
+};
+
+static void decompress_chunks(ChunkBatch *batch) {
+  for (u32 i; (i = batch->next.fetch_add(1, std::memory_order_relaxed)) < batch->chunkCount;) {
+    u64       offset = (u64) i * batch->chunkSize;
+    u64       size   = std::min<u64>(batch->chunkSize, batch->size - offset);
+    const u8 *src    = batch->chunks + batch->offsets[i];
+    u32       stored = batch->storedSizes[i];
+    if (stored == size) {
+      memcpy(batch->dst + offset, src, size);
+    } else if (!decompress_block(src, stored, batch->dst + offset, size)) {
+      batch->failed.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+static void decompress_job(void *data) {
+  auto batch = (ChunkBatch *) data;
+  decompress_chunks(batch);
+  batch->exitedJobs.fetch_add(1, std::memory_order_release);
+}
+
+bool asset_archive_read(const AssetArchive      *archive,
+                        const AssetArchiveEntry *entry,
+                        void                    *dst,
+                        ThreadPool              *pool) {
+  FileView stored = asset_archive_stored(archive, entry);
+  if (!(entry->flags & ASSET_ARCHIVE_ENTRY_COMPRESSED)) {
+    memcpy(dst, stored.data, stored.size);
+    return true;
+  }
+
+  u32  chunkCount  = entry->chunkCount;
+  auto storedSizes = (const u32 *) stored.data;
+  auto offsets     = (u64 *) memory_allocate(sizeof(u64), chunkCount, MemoryTag::Asset);
+  u64  chunksSize  = stored.size - chunkCount * sizeof(u32);
+  u64  offset      = 0;
+  for (u32 i = 0; i < chunkCount; ++i) {
+    offsets[i] = offset;
+    offset += storedSizes[i];
+  }
+  if (offset > chunksSize) {
+    memory_free(offsets, sizeof(u64), chunkCount, MemoryTag::Asset);
+    return false;
+  }
+
+  ChunkBatch batch;
+  batch.chunks      = stored.data + chunkCount * sizeof(u32);
+  batch.storedSizes = storedSizes;
+  batch.offsets     = offsets;
+  batch.dst         = (u8 *) dst;
+  batch.size        = entry->size;
+  batch.chunkSize   = archive->header->chunkSize;
+  batch.chunkCount  = chunkCount;
+
+  // The calling thread takes its share of the chunks instead of sleeping
+  u32 jobCount = pool && chunkCount > 1 ? std::min(pool->thread_count(), chunkCount - 1) : 0;
+  for (u32 i = 0; i < jobCount; ++i) {
+    pool->submit(decompress_job, &batch);
+  }
+  decompress_chunks(&batch);
+  // Every chunk has been taken, the jobs still running are finishing theirs
+  while (batch.exitedJobs.load(std::memory_order_acquire) < jobCount) {
+    std::this_thread::yield();
+  }
+  memory_free(offsets, sizeof(u64), chunkCount, MemoryTag::Asset);
+  return !batch.failed.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,88 @@
+//
+// Created by Hongjian Zhu on 2022/10/29.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+// File layout:
+// AssetArchiveHeader
+// AssetArchiveEntry[tableSize], open addressing hash table keyed by the name's hash
+// Names, not terminated
+// Blobs, each starting on an ASSET_ARCHIVE_ALIGNMENT boundary
+//
+// A compressed blob is split into chunks of `chunkSize` bytes (the last one may be shorter) that
+// are compressed independently, see core/Compression.h, so they can be decompressed in parallel:
+// u32 storedSizes[chunkCount]
+// Chunks, back to back. One whose stored size equals its size wasn't worth compressing and is
+// stored as is.
+static constexpr char ASSET_ARCHIVE_MAGIC[4]   = {'P', 'K', 'A', 'R'};
+static constexpr u32  ASSET_ARCHIVE_VERSION    = 2;
+static constexpr u64  ASSET_ARCHIVE_ALIGNMENT  = 4 * KiB;
+static constexpr u32  ASSET_ARCHIVE_CHUNK_SIZE = 64 * KiB; // Matches can't reach further anyway
+
+struct AssetArchiveHeader {
+  char magic[4];
+  u32  version;
+  u32  entryCount;
+  u32  tableSize; // Power of two, at least twice `entryCount`
+  u64  namesOffset;
+  u64  namesSize;
+  u32  chunkSize;
+  u32  reserved;
+};
+
+enum AssetArchiveEntryFlags : u32 {
+  ASSET_ARCHIVE_ENTRY_COMPRESSED = 1,
+};
+
+struct AssetArchiveEntry {
+  u64 hash;       // 0 marks an empty slot
+  u64 offset;     // From the start of the archive
+  u64 size;       // Once decompressed
+  u64 storedSize; // In the archive
+  u32 nameOffset; // Into the names
+  u32 nameLength;
+  u32 flags;
+  u32 chunkCount; // 0 unless compressed
+};
+
+// Names are paths relative to the assets directory with '/' separators, e.g.
+// "shaders/Builtin.ObjectShader.vert.spv"
+inline u64 asset_archive_hash(CString name, u64 length) {
+  u64 hash = 0xcbf29ce484222325;
+  for (u64 i = 0; i < length; ++i) {
+    hash = (hash ^ (u8) name[i]) * 0x100000001b3;
+  }
+  return hash ? hash : 1;
+}
+
+class ThreadPool;
+
+struct AssetArchive {
+  FileView                  view;
+  const AssetArchiveHeader *header;
+  const AssetArchiveEntry  *table;
+  const char               *names;
+};
+
+// Maps the archive and validates its header and table of contents
+bool asset_archive_open(CString path, AssetArchive *out);
+void asset_archive_close(AssetArchive *archive);
+
+// Returns null if there's no such asset or its entry points outside the archive
+const AssetArchiveEntry *asset_archive_find(const AssetArchive *archive, CString name);
+
+// Returns a view of the stored bytes in the mapped archive, valid until it's closed. Only usable
+// as is when the entry isn't compressed.
+FileView asset_archive_stored(const AssetArchive *archive, const AssetArchiveEntry *entry);
+
+// Writes the `entry->size` bytes of the asset to `dst`, e.g. mapped staging memory, decompressing
+// the chunks on the calling thread and the workers of `pool` if it's given. Fails if the chunks
+// are corrupted, leaving `dst` partially written.
+bool asset_archive_read(const AssetArchive      *archive,
+                        const AssetArchiveEntry *entry,
+                        void                    *dst,
+                        ThreadPool              *pool = nullptr);
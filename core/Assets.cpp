@@ -0,0 +1,127 @@
+//
+// Created by Hongjian Zhu on 2022/10/29.
+//
+
+#include "core/Assets.h"
+#include "StringUtils.h"
+#include "core/AssetArchive.h"
+#include "core/ThreadPool.h"
+#include "logging.h"
+#include "memory.h"
+#include <cstring>
+#include <new>
+
+struct AssetSystemState {
+  AssetArchive archive;
+  bool         hasArchive;
+  char         directory[256];
+  ThreadPool   decompressPool; // Started only if the archive has compressed assets
+};
+
+static AssetSystemState *state = nullptr;
+
+void asset_system_initialize(u64    *memorySize,
+                             void   *pState,
+                             CString archivePath,
+                             CString directory) {
+  *memorySize = sizeof(AssetSystemState);
+  if (!pState) { return; }
+  state = new (pState) AssetSystemState();
+  strncpy(state->directory, directory, sizeof(state->directory) - 1);
+
+  if (archivePath && filesystem_exists(archivePath)) {
+    state->hasArchive = asset_archive_open(archivePath, &state->archive);
+    if (state->hasArchive) {
+      LOGC_INFO(Platform,
+                "[Assets] Mounted '%s', %u assets",
+                archivePath,
+                state->archive.header->entryCount);
+      u32 compressed = 0;
+      for (u32 i = 0; i < state->archive.header->tableSize; ++i) {
+        const auto &entry = state->archive.table[i];
+        if (entry.hash && (entry.flags & ASSET_ARCHIVE_ENTRY_COMPRESSED)) { ++compressed; }
+      }
+      if (compressed > 0) { state->decompressPool.start(); }
+    }
+  }
+  if (!state->hasArchive) {
+    LOGC_INFO(Platform, "[Assets] Loading loose files from '%s'", directory);
+  }
+}
+
+void asset_system_shutdown() {
+  if (!state) { return; }
+  state->decompressPool.stop();
+  if (state->hasArchive) { asset_archive_close(&state->archive); }
+  state->~AssetSystemState();
+  state = nullptr;
+}
+
+static const AssetArchiveEntry *find_archived(CString name) {
+  return state->hasArchive ? asset_archive_find(&state->archive, name) : nullptr;
+}
+
+static ThreadPool *decompress_pool() {
+  return state->decompressPool.thread_count() > 0 ? &state->decompressPool : nullptr;
+}
+
+static bool read_archived(CString name, const AssetArchiveEntry *entry, void *dst) {
+  if (asset_archive_read(&state->archive, entry, dst, decompress_pool())) { return true; }
+  LOGC_ERROR(Platform, "[Assets] '%s' is corrupted in the archive", name);
+  return false;
+}
+
+bool asset_load(CString name, Asset *out) {
+  *out = {};
+  if (auto entry = find_archived(name)) {
+    if (!(entry->flags & ASSET_ARCHIVE_ENTRY_COMPRESSED)) {
+      FileView view = asset_archive_stored(&state->archive, entry);
+      out->data     = view.data;
+      out->size     = view.size;
+      return true;
+    }
+    out->buffer = (u8 *) memory_allocate(entry->size, MemoryTag::Asset);
+    out->data   = out->buffer;
+    out->size   = entry->size;
+    if (read_archived(name, entry, out->buffer)) { return true; }
+    asset_release(out);
+    return false;
+  }
+
+  char path[512];
+  utils::string_format(path, "%s/%s", state->directory, name);
+  if (!filesystem_map(path, &out->file)) { return false; }
+  out->data = out->file.data;
+  out->size = out->file.size;
+  return true;
+}
+
+void asset_release(Asset *asset) {
+  filesystem_unmap(&asset->file);
+  if (asset->buffer) { memory_free(asset->buffer, asset->size, MemoryTag::Asset); }
+  *asset = {};
+}
+
+bool asset_get_size(CString name, u64 *size) {
+  if (auto entry = find_archived(name)) {
+    *size = entry->size;
+    return true;
+  }
+  char path[512];
+  utils::string_format(path, "%s/%s", state->directory, name);
+  return filesystem_size(path, size);
+}
+
+bool asset_read(CString name, void *dst, u64 size) {
+  if (auto entry = find_archived(name)) {
+    if (entry->size != size) { return false; }
+    return read_archived(name, entry, dst);
+  }
+
+  Asset asset;
+  if (!asset_load(name, &asset)) { return false; }
+  bool ok = asset.size == size;
+  if (ok) { memcpy(dst, asset.data, size); }
+  asset_release(&asset);
+  return ok;
+}
@@ -0,0 +1,32 @@
+//
+// Created by Hongjian Zhu on 2022/10/29.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+struct Asset {
+  const u8 *data;
+  u64       size;
+  FileView  file;   // Set if the asset was mapped from a loose file
+  u8       *buffer; // Set if the asset was decompressed, `size` bytes
+};
+
+// `archivePath` is optional, assets not found in it are loaded from `directory`
+void asset_system_initialize(u64    *memorySize,
+                             void   *pState,
+                             CString archivePath,
+                             CString directory);
+void asset_system_shutdown();
+
+// `name` is relative to the assets directory, e.g. "shaders/Builtin.ObjectShader.vert.spv"
+bool asset_load(CString name, Asset *out);
+void asset_release(Asset *asset);
+
+// Streams an asset straight into memory owned by the caller, e.g. mapped staging memory,
+// skipping the intermediate buffer `asset_load` needs for compressed assets. `size` must match
+// `asset_get_size`.
+bool asset_get_size(CString name, u64 *size);
+bool asset_read(CString name, void *dst, u64 size);
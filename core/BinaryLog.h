@@ -0,0 +1,100 @@
+//
+// Created by Hongjian Zhu on 2022/10/26.
+//
+
+#pragma once
+
+#include "defines.h"
+#include <cstring>
+#include <type_traits>
+
+// File layout of pokemoon.log.bin:
+// BinaryLogHeader
+// { u8 BinaryLogRecord, record body }[]
+//
+// Format record: u32 id, u8 level, u32 line, u16 fileLength, file, u16 formatLength, format
+// Entry record:  u32 id, u64 timestampNs, u16 payloadSize, payload
+//
+// An entry's payload holds its arguments, each prefixed by a LogArgType:
+// I64/U64/F64/Pointer: 8 bytes, String: u16 length followed by the characters
+
+static constexpr char BINARY_LOG_MAGIC[4]      = {'P', 'K', 'L', 'B'};
+static constexpr u32  BINARY_LOG_VERSION       = 1;
+static constexpr u32  BINARY_LOG_MAX_PAYLOAD   = 1 * KiB;
+static constexpr u32  BINARY_LOG_MAX_STRING    = 256; // Longer string arguments are truncated
+static constexpr u32  BINARY_LOG_ENTRY_HEADER  = 1 + 4 + 8 + 2;
+static constexpr u32  BINARY_LOG_FORMAT_HEADER = 1 + 4 + 1 + 4 + 2 + 2;
+
+struct BinaryLogHeader {
+  char magic[4];
+  u32  version;
+  u64  startTimeMs; // Wall clock time in ms since the epoch when the log was opened
+};
+
+enum class BinaryLogRecord : u8 { Format = 0, Entry };
+
+enum class LogArgType : u8 { I64 = 0, U64, F64, String, Pointer };
+
+template <typename T>
+inline void binary_log_put(u8 *&cursor, const T &value) {
+  memcpy(cursor, &value, sizeof(T));
+  cursor += sizeof(T);
+}
+
+template <typename T>
+inline T binary_log_get(const u8 *&cursor) {
+  T value;
+  memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+// Characters of a string argument that get logged, a null pointer logs as empty
+template <typename Arg>
+inline u32 log_string_arg_length(const Arg &arg) {
+  // Arrays can't be null, comparing them trips -Waddress
+  if constexpr (std::is_pointer_v<Arg>) {
+    if (!arg) { return 0; }
+  }
+  return (u32) strnlen(arg, BINARY_LOG_MAX_STRING);
+}
+
+// Encodes one argument, `end` is the end of the payload buffer. Arguments that don't fit are
+// dropped, their conversions decode as "<missing>".
+template <typename Arg>
+inline void binary_log_encode_arg(u8 *&cursor, const u8 *end, const Arg &arg) {
+  using T = std::decay_t<Arg>;
+  if constexpr (std::is_same_v<T, char *> || std::is_same_v<T, const char *>) {
+    auto length = (u16) log_string_arg_length(arg);
+    if (cursor + 1 + sizeof(u16) + length > end) { return; }
+    binary_log_put(cursor, LogArgType::String);
+    binary_log_put(cursor, length);
+    memcpy(cursor, arg, length);
+    cursor += length;
+    return;
+  } else {
+    if (cursor + 1 + sizeof(u64) > end) { return; }
+    if constexpr (std::is_floating_point_v<T>) {
+      binary_log_put(cursor, LogArgType::F64);
+      binary_log_put(cursor, (f64) arg);
+    } else if constexpr (std::is_pointer_v<T>) {
+      binary_log_put(cursor, LogArgType::Pointer);
+      binary_log_put(cursor, (u64) (uintptr_t) arg);
+    } else if constexpr (std::is_enum_v<T> || std::is_signed_v<T>) {
+      binary_log_put(cursor, LogArgType::I64);
+      binary_log_put(cursor, (i64) arg);
+    } else {
+      static_assert(std::is_integral_v<T>, "Unsupported log argument type");
+      binary_log_put(cursor, LogArgType::U64);
+      binary_log_put(cursor, (u64) arg);
+    }
+  }
+}
+
+// Returns the payload size
+template <typename... Args>
+inline u32 binary_log_encode(u8 *payload, const Args &...args) {
+  u8 *cursor = payload;
+  (binary_log_encode_arg(cursor, payload + BINARY_LOG_MAX_PAYLOAD, args), ...);
+  return (u32) (cursor - payload);
+}
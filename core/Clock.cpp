@@ -3,15 +3,28 @@
 //
 
 #include "core/Clock.h"
-#include "platform.h"
 
 void Clock::start() {
-  _startTime = platform_get_absolute_time();
+  _startTime = platform_get_time_ns();
+  _lapTime   = _startTime;
   _elapsed   = 0;
 }
 
 void Clock::tick() {
-  if (_startTime != 0) { _elapsed = platform_get_absolute_time() - _startTime; }
+  if (_startTime != 0) { _elapsed = platform_get_time_ns() - _startTime; }
 }
 
 void Clock::stop() { _startTime = 0; }
+
+u64 Clock::lap() {
+  if (_startTime == 0) { return 0; }
+  u64 now     = platform_get_time_ns();
+  u64 lapTime = now - _lapTime;
+  _lapTime    = now;
+  return lapTime;
+}
+
+u64 Clock::split() const {
+  if (_startTime == 0) { return 0; }
+  return platform_get_time_ns() - _lapTime;
+}
@@ -5,10 +5,11 @@
 #pragma once
 
 #include "defines.h"
+#include "platform/timer.h"
 
 class Clock {
 public:
-  // Start the clock, reset elapsed time
+  // Start the clock, reset elapsed time and the current lap
   void start();
 
   // Update the clock, should be called before checking elapsed time, has no effect if not started
@@ -17,10 +18,34 @@ public:
   // Stop the clock, doesn't reset elapsed time
   void stop();
 
-  // Returns elapsed time in seconds, has no effect if not started
-  f64 elapsed() const { return _elapsed; }
+  // Returns nanoseconds since the previous lap, or start, and begins the next lap
+  u64 lap();
+
+  // Returns nanoseconds since the current lap began, without ending it
+  u64 split() const;
+
+  bool is_running() const { return _startTime != 0; }
+
+  // Returns elapsed time as of the last tick, has no effect if not started
+  f64 elapsed() const { return (f64) _elapsed * 1e-9; }
+  u64 elapsed_ns() const { return _elapsed; }
+
+private:
+  u64 _startTime = 0;
+  u64 _lapTime   = 0;
+  u64 _elapsed   = 0;
+};
+
+// Adds the nanoseconds spent in its scope to `*total`, two timer reads and nothing else
+class ScopedTimer {
+public:
+  explicit ScopedTimer(u64 *total) : _total(total), _startTime(platform_get_time_ns()) {}
+  ~ScopedTimer() { *_total += platform_get_time_ns() - _startTime; }
+
+  ScopedTimer(const ScopedTimer &)            = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
 
 private:
-  f64 _startTime;
-  f64 _elapsed;
+  u64 *_total;
+  u64  _startTime;
 };
@@ -0,0 +1,174 @@
+//
+// Created by Hongjian Zhu on 2022/10/30.
+//
+
+#include "core/Compression.h"
+#include <cstring>
+
+static constexpr u32 MIN_MATCH     = 4;
+static constexpr u32 LAST_LITERALS = 5;  // The block always ends with this many literals
+static constexpr u32 MF_LIMIT      = 12; // The last match starts at least this far from the end
+static constexpr u32 MAX_OFFSET    = 65535;
+static constexpr u32 HASH_BITS     = 14;
+
+static inline u32 read_u32(const u8 *p) {
+  u32 value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline u32 hash_u32(u32 sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+// Writes the 255-valued continuation bytes of a length that didn't fit in its token nibble
+static inline u8 *write_length(u8 *op, u64 length) {
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = (u8) length;
+  return op;
+}
+
+static u8 *write_sequence(u8 *op, const u8 *literals, u64 literalLength, u64 matchLength) {
+  u8 *token = op++;
+  *token    = (u8) ((literalLength < 15 ? literalLength : 15) << 4);
+  if (literalLength >= 15) { op = write_length(op, literalLength - 15); }
+  if (literalLength) { memcpy(op, literals, literalLength); } // Both may be null when empty
+  op += literalLength;
+  if (matchLength == 0) { return op; } // Last sequence
+  matchLength -= MIN_MATCH;
+  *token |= (u8) (matchLength < 15 ? matchLength : 15);
+  return op;
+}
+
+u64 compress_block(const u8 *src, u64 size, u8 *dst, u64 capacity) {
+  const u8 *ip     = src;
+  const u8 *anchor = src; // Start of the pending literals
+  const u8 *end    = src + size;
+  u8       *op     = dst;
+  u8       *oend   = dst + capacity;
+
+  if (size >= MF_LIMIT + 1) {
+    u32       table[1 << HASH_BITS] = {}; // Last position of each hashed 4 byte sequence
+    const u8 *matchLimit            = end - LAST_LITERALS;
+    const u8 *mfLimit               = end - MF_LIMIT;
+
+    ++ip;
+    while (ip <= mfLimit) {
+      u32       sequence = read_u32(ip);
+      u32       hash     = hash_u32(sequence);
+      const u8 *ref      = src + table[hash];
+      table[hash]        = (u32) (ip - src);
+      if (ref >= ip || ip - ref > MAX_OFFSET || read_u32(ref) != sequence) {
+        ip += 1 + ((ip - anchor) >> 6); // Skip faster through data that doesn't compress
+        continue;
+      }
+
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+      const u8 *matchEnd = ip + MIN_MATCH;
+      const u8 *refEnd   = ref + MIN_MATCH;
+      while (matchEnd < matchLimit && *matchEnd == *refEnd) {
+        ++matchEnd;
+        ++refEnd;
+      }
+
+      u64 literalLength = ip - anchor;
+      u64 matchLength   = matchEnd - ip;
+      // Token, literal length bytes, literals, offset, match length bytes
+      u64 worstCase = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+      if ((u64) (oend - op) < worstCase + LAST_LITERALS + 1) { return 0; }
+
+      op        = write_sequence(op, anchor, literalLength, matchLength);
+      u16 offset = (u16) (ip - ref);
+      *op++      = (u8) offset;
+      *op++      = (u8) (offset >> 8);
+      if (matchLength - MIN_MATCH >= 15) { op = write_length(op, matchLength - MIN_MATCH - 15); }
+
+      ip     = matchEnd;
+      anchor = ip;
+      if (ip - 2 > src && ip <= mfLimit) {
+        table[hash_u32(read_u32(ip - 2))] = (u32) (ip - 2 - src);
+      }
+    }
+  }
+
+  u64 literalLength = end - anchor;
+  if ((u64) (oend - op) < 1 + literalLength / 255 + 1 + literalLength) { return 0; }
+  op = write_sequence(op, anchor, literalLength, 0);
+  return op - dst;
+}
+
+// Copies in 16 byte steps, overshooting `dst + size` by up to 15 bytes. `src` and `dst` are at
+// least 16 bytes apart if they overlap.
+static inline void wild_copy(u8 *dst, const u8 *src, u64 size) {
+  u8 *end = dst + size;
+  do {
+    memcpy(dst, src, 16);
+    dst += 16;
+    src += 16;
+  } while (dst < end);
+}
+
+// Reads the continuation bytes of a length, false if it runs past the input
+static inline bool read_length(const u8 *&ip, const u8 *iend, u64 &length) {
+  u8 byte;
+  do {
+    if (ip >= iend) { return false; }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool decompress_block(const u8 *src, u64 srcSize, u8 *dst, u64 size) {
+  const u8 *ip   = src;
+  const u8 *iend = src + srcSize;
+  u8       *op   = dst;
+  u8       *oend = dst + size;
+
+  while (ip < iend) {
+    u8  token         = *ip++;
+    u64 literalLength = token >> 4;
+    if (literalLength == 15 && !read_length(ip, iend, literalLength)) { return false; }
+    if (literalLength > (u64) (iend - ip) || literalLength > (u64) (oend - op)) { return false; }
+    // Overshooting is fine as long as it stays in bounds, the following bytes are written later
+    if ((u64) (iend - ip) >= literalLength + 16 && (u64) (oend - op) >= literalLength + 16) {
+      wild_copy(op, ip, literalLength);
+    } else if (literalLength) {
+      memcpy(op, ip, literalLength);
+    }
+    op += literalLength;
+    ip += literalLength;
+    if (ip == iend) { break; } // The last sequence has no match
+
+    if (iend - ip < 2) { return false; }
+    u64 offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (u64) (op - dst)) { return false; }
+    u64 matchLength = token & 15;
+    if (matchLength == 15 && !read_length(ip, iend, matchLength)) { return false; }
+    matchLength += MIN_MATCH;
+    if (matchLength > (u64) (oend - op)) { return false; }
+
+    const u8 *ref = op - offset;
+    if (offset >= 16 && (u64) (oend - op) >= matchLength + 16) {
+      wild_copy(op, ref, matchLength);
+      op += matchLength;
+    } else if (offset >= 8 && (u64) (oend - op) >= matchLength + 8) {
+      u8 *matchEnd = op + matchLength;
+      do {
+        memcpy(op, ref, 8);
+        op += 8;
+        ref += 8;
+      } while (op < matchEnd);
+      op = matchEnd;
+    } else {
+      for (u64 i = 0; i < matchLength; ++i) { // Overlapping, e.g. a run of one repeated byte
+        *op++ = *ref++;
+      }
+    }
+  }
+  return op == oend;
+}
@@ -0,0 +1,21 @@
+//
+// Created by Hongjian Zhu on 2022/10/30.
+//
+
+#pragma once
+
+#include "defines.h"
+
+// LZ4 block format: sequences of a token (literal length << 4 | match length - 4), the literals, a
+// little-endian u16 match offset, with lengths of 15 and above continued in 255-valued bytes. The
+// last sequence has literals only. Blocks are independent, matches reach back at most 64 KiB.
+
+// Worst case size of a compressed block
+inline u64 compress_bound(u64 size) { return size + size / 255 + 16; }
+
+// Returns the compressed size, 0 if it doesn't fit in `capacity`
+u64 compress_block(const u8 *src, u64 size, u8 *dst, u64 capacity);
+
+// Fails on malformed input or if the block doesn't decompress to exactly `size` bytes. Never
+// reads or writes out of bounds.
+bool decompress_block(const u8 *src, u64 srcSize, u8 *dst, u64 size);
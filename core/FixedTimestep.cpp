@@ -0,0 +1,43 @@
+//
+// Created by Hongjian Zhu on 2022/11/8.
+//
+
+#include "core/FixedTimestep.h"
+
+void FixedTimestep::set_rate(u32 ticksPerSecond, u32 maxTicksPerFrame, f64 maxFrameTime) {
+  _ticksPerSecond   = ticksPerSecond ? ticksPerSecond : 60;
+  _maxTicksPerFrame = maxTicksPerFrame ? maxTicksPerFrame : 1;
+  _step             = 1000000000ull / _ticksPerSecond;
+  _maxFrameTime     = (u64) (maxFrameTime * 1e9);
+  _accumulator      = 0;
+}
+
+u32 FixedTimestep::advance(f64 deltaTime) {
+  u64 delta = deltaTime > 0 ? (u64) (deltaTime * 1e9 + 0.5) : 0;
+  if (delta > _maxFrameTime) {
+    _dropped += delta - _maxFrameTime; // A stall, e.g. a breakpoint or loading
+    delta = _maxFrameTime;
+  }
+  _accumulator += delta;
+
+  u64 ticks = _accumulator / _step;
+  if (ticks > _maxTicksPerFrame) {
+    // Behind by more than we can catch up on, keep the fraction so alpha stays smooth
+    _dropped += (ticks - _maxTicksPerFrame) * _step;
+    ++_limitedFrames;
+    ticks = _maxTicksPerFrame;
+  }
+  _accumulator = _accumulator % _step;
+  _ticks += ticks;
+  ++_frames;
+  return (u32) ticks;
+}
+
+FixedTimestepStats FixedTimestep::stats() const {
+  return {
+      .ticks         = _ticks,
+      .frames        = _frames,
+      .limitedFrames = _limitedFrames,
+      .droppedMs     = (f64) _dropped * 1e-6,
+  };
+}
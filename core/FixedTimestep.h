@@ -0,0 +1,45 @@
+//
+// Created by Hongjian Zhu on 2022/11/8.
+//
+
+#pragma once
+
+#include "defines.h"
+
+struct FixedTimestepStats {
+  u64 ticks;
+  u64 frames;        // Frames the time step was advanced for
+  u64 limitedFrames; // Frames that would have run more than `maxTicksPerFrame` ticks
+  f64 droppedMs;     // Simulation time given up to the catch-up limits
+};
+
+// Turns variable frame times into whole simulation ticks of a fixed length. Time accumulates in
+// integer nanoseconds, so the same frame times always give the same ticks. A frame that runs long
+// is caught up with at most `maxTicksPerFrame` ticks, and at most `maxFrameTime` of it counts, the
+// rest is dropped and the simulation runs slower than real time instead of spiraling.
+class FixedTimestep {
+public:
+  void set_rate(u32 ticksPerSecond, u32 maxTicksPerFrame, f64 maxFrameTime = 0.25);
+  u32  rate() const { return _ticksPerSecond; }
+  f64  step() const { return (f64) _step * 1e-9; } // Seconds per tick
+
+  // Adds the frame's `deltaTime` in seconds, returns how many ticks to run for it
+  u32 advance(f64 deltaTime);
+
+  // How far past the latest tick the frame is, in [0, 1), to interpolate from the previous tick
+  f32 alpha() const { return _step ? (f32) ((f64) _accumulator / (f64) _step) : 0; }
+
+  FixedTimestepStats stats() const;
+
+private:
+  u32 _ticksPerSecond   = 0;
+  u32 _maxTicksPerFrame = 0;
+  u64 _step             = 0;
+  u64 _maxFrameTime     = 0;
+  u64 _accumulator      = 0; // Less than one step between frames
+
+  u64 _ticks         = 0;
+  u64 _frames        = 0;
+  u64 _limitedFrames = 0;
+  u64 _dropped       = 0;
+};
@@ -0,0 +1,90 @@
+//
+// Created by Hongjian Zhu on 2022/11/2.
+//
+
+#include "core/FramePacer.h"
+#include "platform/timer.h"
+#include <cmath>
+#include <thread>
+
+static constexpr u64 MIN_SPIN_MARGIN = 200 * 1000;  // Even a quiet system oversleeps ~50-100 us
+static constexpr u64 MAX_SPIN_MARGIN = 2000 * 1000; // Past this a frame worth of CPU is burnt
+static constexpr u64 YIELD_THRESHOLD = 50 * 1000;   // Closer than this, yielding risks a late wake
+
+void FramePacer::set_target(u32 framesPerSecond) {
+  _framesPerSecond = framesPerSecond;
+  _period          = framesPerSecond ? 1000000000ull / framesPerSecond : 0;
+  _deadline        = 0; // Restart the schedule from the next frame
+  _spinMargin      = MIN_SPIN_MARGIN * 2;
+  reset_stats();
+}
+
+void FramePacer::wait() {
+  u64 now = platform_get_time_ns();
+  if (_period != 0) {
+    if (_deadline == 0) { _deadline = now + _period; }
+
+    if (now < _deadline) {
+      if (_deadline - now > _spinMargin) {
+        u64 wake = _deadline - _spinMargin;
+        platform_sleep_until_ns(wake);
+        now = platform_get_time_ns();
+        // Track the oversleep, quick to grow and slow to shrink
+        u64 oversleep = now > wake ? now - wake : 0;
+        u64 wanted    = oversleep * 2;
+        _spinMargin   = wanted > _spinMargin ? wanted : _spinMargin - (_spinMargin - wanted) / 16;
+        _spinMargin   = _spinMargin < MIN_SPIN_MARGIN ? MIN_SPIN_MARGIN : _spinMargin;
+        _spinMargin   = _spinMargin > MAX_SPIN_MARGIN ? MAX_SPIN_MARGIN : _spinMargin;
+      }
+      while (now < _deadline) {
+        if (_deadline - now > YIELD_THRESHOLD) { std::this_thread::yield(); }
+        now = platform_get_time_ns();
+      }
+      _maxLateness = now - _deadline > _maxLateness ? now - _deadline : _maxLateness;
+      _deadline += _period;
+    } else {
+      // Missed it. Resynchronize rather than rushing the next frames out to catch up.
+      u64 behind = (now - _deadline) / _period + 1;
+      _missedFrames += behind;
+      _deadline += behind * _period;
+    }
+  }
+
+  if (_lastDelivery != 0) {
+    u64 interval = now - _lastDelivery;
+    ++_frames;
+    f64 delta = (f64) interval - _mean;
+    _mean += delta / (f64) _frames;
+    _m2 += delta * ((f64) interval - _mean);
+    _minInterval = (_frames == 1 || interval < _minInterval) ? interval : _minInterval;
+    _maxInterval = interval > _maxInterval ? interval : _maxInterval;
+  }
+  _lastDelivery = now;
+}
+
+void FramePacer::restart() {
+  _deadline     = 0;
+  _lastDelivery = 0;
+}
+
+FramePacerStats FramePacer::stats() const {
+  FramePacerStats stats = {.frames = _frames, .missedFrames = _missedFrames};
+  if (_frames == 0) { return stats; }
+  stats.meanIntervalMs   = _mean * 1e-6;
+  stats.stdDevIntervalMs = sqrt(_m2 / (f64) _frames) * 1e-6;
+  stats.minIntervalMs    = (f64) _minInterval * 1e-6;
+  stats.maxIntervalMs    = (f64) _maxInterval * 1e-6;
+  stats.maxLatenessUs    = (f64) _maxLateness * 1e-3;
+  return stats;
+}
+
+void FramePacer::reset_stats() {
+  _lastDelivery = 0;
+  _frames       = 0;
+  _mean         = 0;
+  _m2           = 0;
+  _minInterval  = 0;
+  _maxInterval  = 0;
+  _maxLateness  = 0;
+  _missedFrames = 0;
+}
@@ -0,0 +1,52 @@
+//
+// Created by Hongjian Zhu on 2022/11/2.
+//
+
+#pragma once
+
+#include "defines.h"
+
+struct FramePacerStats {
+  u64 frames;
+  f64 meanIntervalMs; // Between consecutive frame deliveries
+  f64 stdDevIntervalMs;
+  f64 minIntervalMs;
+  f64 maxIntervalMs;
+  f64 maxLatenessUs; // How far past its deadline a paced frame was released
+  u64 missedFrames;  // Frames that took longer than the period, the deadline moved on without them
+};
+
+// Delivers frames on a fixed period with absolute deadlines, so a late wake doesn't push the
+// following frames back. Sleeps until shortly before the deadline and spins the rest of the way,
+// the spin margin follows how late the OS has been waking us.
+class FramePacer {
+public:
+  // A `framesPerSecond` of 0 leaves the rate unlimited, only statistics are kept
+  void set_target(u32 framesPerSecond);
+  u32  target() const { return _framesPerSecond; }
+
+  // Called once per frame after its work is submitted, returns once the frame's slot is over
+  void wait();
+
+  // Starts the schedule over from the next frame, after frames were deliberately not paced, e.g.
+  // in the background. Neither the pause nor the deadlines it passed count as missed.
+  void restart();
+
+  FramePacerStats stats() const;
+  void            reset_stats();
+
+private:
+  u32 _framesPerSecond = 0;
+  u64 _period          = 0;
+  u64 _deadline        = 0;
+  u64 _spinMargin      = 0; // Woken this much before the deadline, then spin
+
+  u64 _lastDelivery = 0;
+  u64 _frames       = 0; // Intervals recorded, one less than the frames delivered
+  f64 _mean         = 0; // Welford's running mean and sum of squared deviations, nanoseconds
+  f64 _m2           = 0;
+  u64 _minInterval  = 0;
+  u64 _maxInterval  = 0;
+  u64 _maxLateness  = 0;
+  u64 _missedFrames = 0;
+};
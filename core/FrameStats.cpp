@@ -0,0 +1,357 @@
+//
+// Created by Hongjian Zhu on 2022/11/5.
+//
+
+#include "core/FrameStats.h"
+#include "logging.h"
+#include "platform/filesystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <new>
+
+static constexpr f64 HITCH_FACTOR       = 2.0;
+static constexpr u64 HITCH_WARMUP       = 30;   // Frames before the average interval is trusted
+static constexpr f64 INTERVAL_SMOOTHING = 1.0 / 32;
+
+static CString metricNames[FRAME_METRIC_COUNT] = {
+    "frame",
+    "cpu",
+    "update",
+    "render",
+    "present_wait",
+    "gpu",
+};
+
+struct FrameStatsState {
+  u32 histogram[FRAME_METRIC_COUNT][FRAME_STATS_BUCKET_COUNT];
+  u64 samples[FRAME_METRIC_COUNT];
+  u64 totalNs[FRAME_METRIC_COUNT];
+  u64 maxNs[FRAME_METRIC_COUNT];
+
+  f32 window[FRAME_STATS_WINDOW][FRAME_METRIC_COUNT]; // In ms, negative if not sampled that frame
+  u64 windowFrames;                                   // Frames committed so far
+
+  u64  current[FRAME_METRIC_COUNT]; // The frame in progress
+  bool touched[FRAME_METRIC_COUNT];
+  u64  frameStart;
+  bool skipInterval;
+
+  f64 averageIntervalMs;
+  u64 hitches;
+
+  PerfCounters counterWindow[FRAME_STATS_WINDOW]; // Zero if not counted that frame
+  PerfCounters counterTotals;
+  u64          counterFrames;
+  PerfCounters lastCounters; // At the start of the frame in progress
+  bool         countersRead;
+};
+
+static FrameStatsState *state = nullptr;
+
+void frame_stats_initialize(u64 *memorySize, void *pState) {
+  *memorySize = sizeof(FrameStatsState);
+  if (!pState) { return; }
+  state               = new (pState) FrameStatsState();
+  state->skipInterval = true; // No frame before the first one
+}
+
+void frame_stats_shutdown() {
+  if (!state) { return; }
+  state->~FrameStatsState();
+  state = nullptr;
+}
+
+static void record(u8 metric, u64 ns) {
+  u64 bucket = ns / (FRAME_STATS_BUCKET_US * 1000);
+  if (bucket >= FRAME_STATS_BUCKET_COUNT) { bucket = FRAME_STATS_BUCKET_COUNT - 1; }
+  ++state->histogram[metric][bucket];
+  ++state->samples[metric];
+  state->totalNs[metric] += ns;
+  if (ns > state->maxNs[metric]) { state->maxNs[metric] = ns; }
+}
+
+static void accumulate(PerfCounters &total, const PerfCounters &counters) {
+  total.cycles += counters.cycles;
+  total.instructions += counters.instructions;
+  total.cacheMisses += counters.cacheMisses;
+  total.branchMisses += counters.branchMisses;
+}
+
+// What was counted since the previous frame start, false when there's nothing to attribute
+static bool read_frame_counters(PerfCounters *out) {
+  PerfCounters now = {};
+  if (!perf_counters_read_all(&now)) { return false; }
+  bool read           = state->countersRead;
+  *out                = perf_counters_delta(state->lastCounters, now);
+  state->lastCounters = now;
+  state->countersRead = true;
+  return read;
+}
+
+static void commit_frame(u64 interval) {
+  constexpr u8 frame = (u8) FrameMetric::Frame;
+
+  PerfCounters counters = {};
+  bool         counted  = read_frame_counters(&counters) && !state->skipInterval;
+  if (!state->skipInterval) {
+    state->current[frame] = interval;
+    state->touched[frame] = true;
+
+    f64 ms     = (f64) interval * 1e-6;
+    u64 frames = state->samples[frame];
+    if (frames >= HITCH_WARMUP && ms > state->averageIntervalMs * HITCH_FACTOR) {
+      ++state->hitches;
+    }
+    f64 average              = state->averageIntervalMs;
+    state->averageIntervalMs = frames == 0 ? ms : average + (ms - average) * INTERVAL_SMOOTHING;
+  }
+  state->skipInterval = false;
+
+  u64 slot                   = state->windowFrames++ % FRAME_STATS_WINDOW;
+  state->counterWindow[slot] = counted ? counters : PerfCounters{};
+  if (counted) {
+    accumulate(state->counterTotals, counters);
+    ++state->counterFrames;
+  }
+
+  auto &row = state->window[slot];
+  for (u8 i = 0; i < FRAME_METRIC_COUNT; ++i) {
+    row[i] = state->touched[i] ? (f32) ((f64) state->current[i] * 1e-6) : -1.0f;
+    if (state->touched[i]) { record(i, state->current[i]); }
+    state->current[i] = 0;
+    state->touched[i] = false;
+  }
+}
+
+void frame_stats_begin_frame() {
+  if (!state) { return; }
+  u64 now = platform_get_time_ns();
+  if (state->frameStart) { commit_frame(now - state->frameStart); }
+  state->frameStart = now;
+}
+
+void frame_stats_skip_interval() {
+  if (state) { state->skipInterval = true; }
+}
+
+void frame_stats_reset() {
+  if (!state) { return; }
+  u64          frameStart   = state->frameStart;
+  PerfCounters lastCounters = state->lastCounters;
+  bool         countersRead = state->countersRead;
+  state                     = new (state) FrameStatsState();
+  state->frameStart         = frameStart;
+  state->lastCounters       = lastCounters;
+  state->countersRead       = countersRead;
+}
+
+void frame_stats_add(FrameMetric metric, u64 ns) {
+  if (!state) { return; }
+  state->current[(u8) metric] += ns;
+  state->touched[(u8) metric] = true;
+}
+
+// Upper edge of the bucket holding the sample at `percentile`, clamped to the largest sample
+static f64 histogram_percentile(u8 metric, f64 percentile) {
+  u64 count = state->samples[metric];
+  if (count == 0) { return 0; }
+  u64 rank = (u64) std::ceil(percentile * (f64) count);
+  if (rank == 0) { rank = 1; }
+  f64 maxMs = (f64) state->maxNs[metric] * 1e-6;
+  u64 seen  = 0;
+  for (u32 i = 0; i < FRAME_STATS_BUCKET_COUNT - 1; ++i) {
+    seen += state->histogram[metric][i];
+    if (seen >= rank) { return std::min((f64) (i + 1) * FRAME_STATS_BUCKET_US * 1e-3, maxMs); }
+  }
+  return maxMs;
+}
+
+static FrameMetricSummary recent_summary(u8 metric) {
+  static f32 sorted[FRAME_STATS_WINDOW];
+  u64        frames = std::min<u64>(state->windowFrames, FRAME_STATS_WINDOW);
+  u32        count  = 0;
+  f64        total  = 0;
+  for (u64 i = 0; i < frames; ++i) {
+    f32 ms = state->window[i][metric];
+    if (ms < 0) { continue; }
+    sorted[count++] = ms;
+    total += ms;
+  }
+  if (count == 0) { return {}; }
+  std::sort(sorted, sorted + count);
+
+  auto at = [count](f64 percentile) {
+    u32 rank = (u32) std::ceil(percentile * count);
+    return (f64) sorted[rank == 0 ? 0 : rank - 1];
+  };
+  return {
+      .samples = count,
+      .meanMs  = total / count,
+      .p50Ms   = at(0.50),
+      .p95Ms   = at(0.95),
+      .p99Ms   = at(0.99),
+      .maxMs   = sorted[count - 1],
+  };
+}
+
+FrameMetricSummary frame_stats_summary(FrameMetric metric, bool recent) {
+  if (!state) { return {}; }
+  u8 i = (u8) metric;
+  if (recent) { return recent_summary(i); }
+  u64 count = state->samples[i];
+  return {
+      .samples = count,
+      .meanMs  = count ? (f64) state->totalNs[i] * 1e-6 / (f64) count : 0,
+      .p50Ms   = histogram_percentile(i, 0.50),
+      .p95Ms   = histogram_percentile(i, 0.95),
+      .p99Ms   = histogram_percentile(i, 0.99),
+      .maxMs   = (f64) state->maxNs[i] * 1e-6,
+  };
+}
+
+static FrameCounterSummary counter_summary(const PerfCounters &counters, u64 samples) {
+  if (samples == 0) { return {}; }
+  auto per = [](u64 value, u64 count) { return count ? (f64) value / (f64) count : 0; };
+  return {
+      .samples               = samples,
+      .ipc                   = per(counters.instructions, counters.cycles),
+      .cacheMissesPerKilo    = per(counters.cacheMisses * 1000, counters.instructions),
+      .branchMissesPerKilo   = per(counters.branchMisses * 1000, counters.instructions),
+      .cyclesPerSample       = per(counters.cycles, samples),
+      .instructionsPerSample = per(counters.instructions, samples),
+  };
+}
+
+FrameCounterSummary frame_stats_counters(bool recent) {
+  if (!state) { return {}; }
+  if (!recent) { return counter_summary(state->counterTotals, state->counterFrames); }
+  PerfCounters total  = {};
+  u64          frames = 0;
+  for (u64 i = 0; i < std::min<u64>(state->windowFrames, FRAME_STATS_WINDOW); ++i) {
+    auto &counters = state->counterWindow[i];
+    if (counters.cycles == 0 && counters.instructions == 0) { continue; }
+    accumulate(total, counters);
+    ++frames;
+  }
+  return counter_summary(total, frames);
+}
+
+u32 frame_stats_zone_counters(FrameZoneCounterSummary *out, u32 capacity) {
+  static PerfZoneCounters zones[PERF_COUNTERS_MAX_ZONES];
+  u32 count = perf_counters_get_zones(zones, std::min(capacity, PERF_COUNTERS_MAX_ZONES));
+  for (u32 i = 0; i < count; ++i) {
+    out[i] = {.name = zones[i].name, .summary = counter_summary(zones[i].counters, zones[i].count)};
+  }
+  return count;
+}
+
+u64 frame_stats_hitches() { return state ? state->hitches : 0; }
+
+CString frame_stats_metric_name(FrameMetric metric) { return metricNames[(u8) metric]; }
+
+const u32 *frame_stats_histogram(FrameMetric metric) {
+  return state ? state->histogram[(u8) metric] : nullptr;
+}
+
+void frame_stats_log() {
+  if (!state) { return; }
+  LOGC_INFO(General,
+            "[FrameStats] %llu frames, %llu hitches (over %.1fx the average interval)",
+            (unsigned long long) state->samples[(u8) FrameMetric::Frame],
+            (unsigned long long) state->hitches,
+            HITCH_FACTOR);
+  for (u8 i = 0; i < FRAME_METRIC_COUNT; ++i) {
+    if (state->samples[i] == 0) { continue; }
+    auto all    = frame_stats_summary((FrameMetric) i);
+    auto recent = recent_summary(i);
+    LOGC_INFO(General,
+              "[FrameStats]   %-12s p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms, "
+              "recent p99 %6.2f",
+              metricNames[i],
+              all.p50Ms,
+              all.p95Ms,
+              all.p99Ms,
+              all.maxMs,
+              recent.p99Ms);
+  }
+
+  if (state->counterFrames == 0) { return; }
+  auto counters = frame_stats_counters();
+  LOGC_INFO(General,
+            "[FrameStats]   %-12s IPC %5.2f  cache misses %6.2f  branch misses %6.2f /1k instr, "
+            "%.2fM instr/frame, recent IPC %5.2f",
+            "counters",
+            counters.ipc,
+            counters.cacheMissesPerKilo,
+            counters.branchMissesPerKilo,
+            counters.instructionsPerSample * 1e-6,
+            frame_stats_counters(true).ipc);
+  static FrameZoneCounterSummary zones[PERF_COUNTERS_MAX_ZONES];
+  u32 zoneCount = frame_stats_zone_counters(zones, PERF_COUNTERS_MAX_ZONES);
+  std::sort(zones, zones + zoneCount, [](auto &a, auto &b) {
+    return a.summary.cyclesPerSample * (f64) a.summary.samples >
+           b.summary.cyclesPerSample * (f64) b.summary.samples;
+  });
+  for (u32 i = 0; i < zoneCount; ++i) {
+    auto &zone = zones[i];
+    LOGC_INFO(General,
+              "[FrameStats]     %-30s IPC %5.2f  cache misses %6.2f  branch misses %6.2f /1k "
+              "instr, %.1fk cycles x %llu",
+              zone.name,
+              zone.summary.ipc,
+              zone.summary.cacheMissesPerKilo,
+              zone.summary.branchMissesPerKilo,
+              zone.summary.cyclesPerSample * 1e-3,
+              (unsigned long long) zone.summary.samples);
+  }
+}
+
+bool frame_stats_write_csv(CString path) {
+  if (!state) { return false; }
+  FileHandle file;
+  if (!filesystem_open(path, FILE_MODE_WRITE, false, &file)) {
+    LOGC_ERROR(General, "[FrameStats] Failed to open '%s'", path);
+    return false;
+  }
+
+  char buffer[256];
+  bool ok = true;
+  auto write_line = [&](i32 n) {
+    u64 written = 0;
+    if (n < 0 || (u64) n >= sizeof(buffer) ||
+        !filesystem_write(&file, (u64) n, buffer, &written)) {
+      ok = false;
+    }
+  };
+  write_line(snprintf(buffer,
+                      sizeof(buffer),
+                      "metric,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,"
+                      "recent_p50_ms,recent_p95_ms,recent_p99_ms,recent_max_ms\n"));
+  for (u8 i = 0; i < FRAME_METRIC_COUNT && ok; ++i) {
+    auto all    = frame_stats_summary((FrameMetric) i);
+    auto recent = recent_summary(i);
+    write_line(snprintf(buffer,
+                        sizeof(buffer),
+                        "%s,%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                        metricNames[i],
+                        (unsigned long long) all.samples,
+                        all.meanMs,
+                        all.p50Ms,
+                        all.p95Ms,
+                        all.p99Ms,
+                        all.maxMs,
+                        recent.p50Ms,
+                        recent.p95Ms,
+                        recent.p99Ms,
+                        recent.maxMs));
+  }
+  filesystem_close(&file);
+
+  if (!ok) {
+    LOGC_ERROR(General, "[FrameStats] Failed to write '%s'", path);
+    return false;
+  }
+  LOGC_INFO(General, "[FrameStats] Wrote '%s'", path);
+  return true;
+}
@@ -0,0 +1,104 @@
+//
+// Created by Hongjian Zhu on 2022/11/5.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "platform/perf_counters.h"
+#include "platform/timer.h"
+
+static constexpr u8 FRAME_METRIC_COUNT = 6;
+enum class FrameMetric : u8 {
+  Frame = 0,   // Between consecutive frame starts, what the player sees
+  Cpu,         // Work on the main thread, without the frame pacer's wait
+  Update,
+  Render,      // Recording and submitting, present wait included
+  PresentWait, // Blocked on fences, image acquisition and present
+  Gpu,         // Read back `maxFramesInFlight` frames late
+  // When adding more variables, make sure to update FRAME_METRIC_COUNT and the names in
+  // FrameStats.cpp
+};
+
+static constexpr u32 FRAME_STATS_WINDOW       = 1024; // Recent frames kept for exact percentiles
+static constexpr u32 FRAME_STATS_BUCKET_US    = 100;  // Histogram resolution
+static constexpr u32 FRAME_STATS_BUCKET_COUNT = 501;  // Up to 50 ms, the last one takes the rest
+
+struct FrameMetricSummary {
+  u64 samples;
+  f64 meanMs;
+  f64 p50Ms;
+  f64 p95Ms;
+  f64 p99Ms;
+  f64 maxMs;
+};
+
+// Rates of the hardware counters over some frames or zone entries
+struct FrameCounterSummary {
+  u64 samples;               // Frames, or times a zone was entered
+  f64 ipc;                   // Instructions per cycle
+  f64 cacheMissesPerKilo;    // Per 1000 instructions
+  f64 branchMissesPerKilo;   // Per 1000 instructions
+  f64 cyclesPerSample;
+  f64 instructionsPerSample;
+};
+
+struct FrameZoneCounterSummary {
+  CString             name;
+  FrameCounterSummary summary;
+};
+
+/**
+ * Collects the time spent per frame in each FrameMetric. Every sample goes into a histogram, whose
+ * percentiles cover the whole run at FRAME_STATS_BUCKET_US resolution, and the last
+ * FRAME_STATS_WINDOW frames are kept as is. A frame that takes more than twice the recent average
+ * interval counts as a hitch. With perf counters on, the counts of every attached thread are
+ * also read at each frame start and attributed to the frame that just ended.
+ */
+void frame_stats_initialize(u64 *memorySize, void *pState);
+void frame_stats_shutdown();
+
+// Closes the previous frame and starts timing the next, called at the top of the main loop
+void frame_stats_begin_frame();
+
+// The next frame started after a pause, e.g. while minimized, its interval isn't a frame time
+void frame_stats_skip_interval();
+
+// Drops everything collected so far, e.g. once warmed up. Call right after
+// frame_stats_begin_frame(), the frame just started is the first one kept.
+void frame_stats_reset();
+
+// Adds to the current frame's time in `metric`
+void frame_stats_add(FrameMetric metric, u64 ns);
+
+// Over the whole run, or exactly over the recent window
+FrameMetricSummary frame_stats_summary(FrameMetric metric, bool recent = false);
+u64                frame_stats_hitches();
+CString            frame_stats_metric_name(FrameMetric metric);
+
+// Sample counts per FRAME_STATS_BUCKET_US wide bucket, FRAME_STATS_BUCKET_COUNT of them
+const u32 *frame_stats_histogram(FrameMetric metric);
+
+// Counted across all attached threads between frame starts, empty without perf counters
+FrameCounterSummary frame_stats_counters(bool recent = false);
+
+// Per PROFILE_SCOPE zone over the whole run, with perf counters zones on. Returns how many were
+// written to `out`.
+u32 frame_stats_zone_counters(FrameZoneCounterSummary *out, u32 capacity);
+
+void frame_stats_log();
+bool frame_stats_write_csv(CString path);
+
+// Adds the time spent in its scope to the current frame's `metric`
+class FrameStatsTimer {
+public:
+  explicit FrameStatsTimer(FrameMetric metric) : _metric(metric), _start(platform_get_time_ns()) {}
+  ~FrameStatsTimer() { frame_stats_add(_metric, platform_get_time_ns() - _start); }
+
+  FrameStatsTimer(const FrameStatsTimer &)            = delete;
+  FrameStatsTimer &operator=(const FrameStatsTimer &) = delete;
+
+private:
+  FrameMetric _metric;
+  u64         _start;
+};
@@ -0,0 +1,287 @@
+//
+// Created by Hongjian Zhu on 2022/10/25.
+//
+
+#include "core/InputActions.h"
+#include "logging.h"
+#include "memory.h"
+#include "platform/filesystem.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+static_assert(INPUT_ACTION_COUNT <= 64, "Actions are stored in a u64 bitset");
+
+static CString actionNames[INPUT_ACTION_COUNT] = {
+    "Quit",
+    "MemoryReport",
+    "Jump",
+    "ProfileCapture",
+};
+
+static CString axisNames[INPUT_AXIS_COUNT] = {
+    "MoveX",
+    "MoveY",
+};
+
+// Used when the config can't be read
+static CString builtinBindings[] = {
+    "action Quit key ESC",
+    "action MemoryReport key M",
+    "action Jump key Space",
+    "action ProfileCapture key P",
+    "axis MoveX key D 1",
+    "axis MoveX key A -1",
+    "axis MoveX key Right 1",
+    "axis MoveX key Left -1",
+    "axis MoveY key W 1",
+    "axis MoveY key S -1",
+    "axis MoveY key Up 1",
+    "axis MoveY key Down -1",
+};
+
+struct KeyName {
+  CString name;
+  Key     key;
+};
+
+// Letters and digits are written as themselves, numbers are taken as raw key codes
+static const KeyName keyNames[] = {
+    {"Space", Key::Space},
+    {"ESC", Key::ESC},
+    {"Enter", Key::Enter},
+    {"TAB", Key::TAB},
+    {"Backspace", Key::Backspace},
+    {"Right", Key::Right},
+    {"Left", Key::Left},
+    {"Down", Key::Down},
+    {"Up", Key::Up},
+};
+
+struct AxisBinding {
+  u8  axis; // INPUT_AXIS_COUNT if the key drives no axis
+  f32 scale;
+};
+
+struct InputActionsState {
+  // Dense binding tables, each entry is the bitset of actions the key/button triggers
+  u64         keyActions[KEY_COUNT];
+  u64         buttonActions[MOUSE_BUTTON_COUNT];
+  AxisBinding keyAxes[KEY_COUNT];
+
+  // Evaluated once per frame
+  u64 down;
+  u64 pressed;
+  u64 released;
+  f32 axes[INPUT_AXIS_COUNT];
+};
+
+static InputActionsState *state = nullptr;
+
+static bool parse_key(CString token, Key &out) {
+  if (token[0] != 0 && token[1] == 0 && isalnum(token[0])) {
+    out = (Key) toupper(token[0]); // Key codes of letters and digits match their ASCII value
+    return true;
+  }
+  for (const auto &keyName : keyNames) {
+    if (strcasecmp(token, keyName.name) == 0) {
+      out = keyName.key;
+      return true;
+    }
+  }
+  char *end  = nullptr;
+  auto  code = strtol(token, &end, 10);
+  if (*end != 0 || code <= 0 || code >= KEY_COUNT) { return false; }
+  out = (Key) code;
+  return true;
+}
+
+static bool parse_mouse_button(CString token, MouseButton &out) {
+  CString names[] = {"Left", "Right", "Middle"};
+  for (u16 i = 0; i < 3; ++i) {
+    if (strcasecmp(token, names[i]) == 0) {
+      out = i;
+      return true;
+    }
+  }
+  char *end    = nullptr;
+  auto  button = strtol(token, &end, 10);
+  if (*end != 0 || button < 0 || button >= MOUSE_BUTTON_COUNT) { return false; }
+  out = (MouseButton) button;
+  return true;
+}
+
+template <u32 N>
+static i32 find_name(CString (&names)[N], CString token) {
+  for (u32 i = 0; i < N; ++i) {
+    if (strcasecmp(names[i], token) == 0) { return (i32) i; }
+  }
+  return -1;
+}
+
+// Blank and comment lines are accepted
+static bool parse_binding(StringView text) {
+  // Tokenized in a copy on the stack, bindings are short
+  char line[256];
+  if (text.length >= sizeof(line)) { return false; }
+  memcpy(line, text.ptr, text.length);
+  line[text.length] = 0;
+  if (auto comment = strchr(line, '#')) { *comment = 0; }
+
+  char   *tokens[5] = {};
+  u32     count     = 0;
+  char   *cursor    = nullptr;
+  CString delimiter = " \t\r\n";
+  for (char *token = strtok_r(line, delimiter, &cursor); token && count < 5;
+       token       = strtok_r(nullptr, delimiter, &cursor)) {
+    tokens[count++] = token;
+  }
+  if (count == 0) { return true; }
+  if (count < 4) { return false; }
+
+  bool isKey = strcmp(tokens[2], "key") == 0;
+  if (strcmp(tokens[0], "action") == 0) {
+    i32 action = find_name(actionNames, tokens[1]);
+    if (action < 0) { return false; }
+    if (isKey) {
+      Key key;
+      if (!parse_key(tokens[3], key)) { return false; }
+      input_actions_bind_key((InputAction) action, key);
+      return true;
+    }
+    MouseButton button;
+    if (strcmp(tokens[2], "mouse") != 0 || !parse_mouse_button(tokens[3], button)) { return false; }
+    input_actions_bind_mouse_button((InputAction) action, button);
+    return true;
+  }
+  if (strcmp(tokens[0], "axis") == 0 && isKey && count == 5) {
+    i32 axis = find_name(axisNames, tokens[1]);
+    Key key;
+    if (axis < 0 || !parse_key(tokens[3], key)) { return false; }
+    input_actions_bind_axis((InputAxis) axis, key, strtof(tokens[4], nullptr));
+    return true;
+  }
+  return false;
+}
+
+static void load_builtin_bindings() {
+  input_actions_clear();
+  for (auto binding : builtinBindings) {
+    ASSERT(parse_binding({binding, strlen(binding)}));
+  }
+}
+
+void input_actions_initialize(u64 *memorySize, void *pState, CString configPath) {
+  *memorySize = sizeof(InputActionsState);
+  if (!pState) { return; }
+  state = (InputActionsState *) pState;
+  if (!configPath || !input_actions_load(configPath)) {
+    LOGC_INFO(Input, "[InputActions] Using builtin bindings");
+    load_builtin_bindings();
+  }
+}
+
+void input_actions_shutdown() { state = nullptr; }
+
+bool input_actions_load(CString path) {
+  LineReader reader;
+  if (!line_reader_open(path, &reader)) { return false; }
+
+  input_actions_clear();
+  StringView line;
+  u32        lineNumber = 0;
+  while (line_reader_next(&reader, &line)) {
+    ++lineNumber;
+    if (!parse_binding(line)) {
+      LOGC_WARN(Input, "[InputActions] %s:%u: invalid binding, ignored", path, lineNumber);
+    }
+  }
+  line_reader_close(&reader);
+  return true;
+}
+
+void input_actions_clear() {
+  memory_zero(state->keyActions, sizeof(state->keyActions));
+  memory_zero(state->buttonActions, sizeof(state->buttonActions));
+  for (auto &binding : state->keyAxes) {
+    binding = {.axis = INPUT_AXIS_COUNT, .scale = 0};
+  }
+}
+
+void input_actions_bind_key(InputAction action, Key key) {
+  if ((u16) key >= KEY_COUNT) { return; }
+  state->keyActions[(u16) key] |= 1ull << (u8) action;
+}
+
+void input_actions_bind_mouse_button(InputAction action, MouseButton button) {
+  if (button >= MOUSE_BUTTON_COUNT) { return; }
+  state->buttonActions[button] |= 1ull << (u8) action;
+}
+
+void input_actions_bind_axis(InputAxis axis, Key key, f32 scale) {
+  if ((u16) key >= KEY_COUNT) { return; }
+  state->keyAxes[(u16) key] = {.axis = (u8) axis, .scale = scale};
+}
+
+void input_actions_update() {
+  u64 down                   = 0;
+  f32 axes[INPUT_AXIS_COUNT] = {};
+
+  Key keys[KEY_COUNT];
+  u32 keyCount = input_get_keys_down(keys, KEY_COUNT);
+  for (u32 i = 0; i < keyCount; ++i) {
+    auto key = (u16) keys[i];
+    down |= state->keyActions[key];
+    const auto &binding = state->keyAxes[key];
+    if (binding.axis < INPUT_AXIS_COUNT) { axes[binding.axis] += binding.scale; }
+  }
+
+  MouseButton buttons[MOUSE_BUTTON_COUNT];
+  u32         buttonCount = input_get_mouse_buttons_down(buttons, MOUSE_BUTTON_COUNT);
+  for (u32 i = 0; i < buttonCount; ++i) {
+    down |= state->buttonActions[buttons[i]];
+  }
+
+  // A press and release within one poll leave the held state as it was, find them in the samples.
+  // Only taps of actions that weren't held before, or aren't held after, are edges.
+  static InputSample samples[INPUT_SAMPLE_CAPACITY];
+  u64                tapPressed  = 0;
+  u64                tapReleased = 0;
+  u32                sampleCount = input_get_frame_samples(samples, INPUT_SAMPLE_CAPACITY);
+  for (u32 i = 0; i < sampleCount; ++i) {
+    const auto &sample  = samples[i];
+    u64         actions = 0;
+    if (sample.type == InputSampleType::Key && sample.code < KEY_COUNT) {
+      actions = state->keyActions[sample.code];
+    } else if (sample.type == InputSampleType::MouseButton && sample.code < MOUSE_BUTTON_COUNT) {
+      actions = state->buttonActions[sample.code];
+    }
+    if (sample.pressed) {
+      tapPressed |= actions;
+    } else {
+      tapReleased |= actions;
+    }
+  }
+
+  state->pressed  = (down | tapPressed) & ~state->down;
+  state->released = (state->down | tapReleased) & ~down;
+  state->down     = down;
+  for (u8 i = 0; i < INPUT_AXIS_COUNT; ++i) {
+    state->axes[i] = axes[i] < -1.0f ? -1.0f : (axes[i] > 1.0f ? 1.0f : axes[i]);
+  }
+}
+
+u64 input_actions_get_down() { return state->down; }
+
+u64 input_actions_get_pressed() { return state->pressed; }
+
+u64 input_actions_get_released() { return state->released; }
+
+bool input_action_is_down(InputAction action) { return (state->down >> (u8) action) & 1; }
+
+bool input_action_pressed(InputAction action) { return (state->pressed >> (u8) action) & 1; }
+
+bool input_action_released(InputAction action) { return (state->released >> (u8) action) & 1; }
+
+f32 input_axis_get(InputAxis axis) { return state->axes[(u8) axis]; }
@@ -0,0 +1,63 @@
+//
+// Created by Hongjian Zhu on 2022/10/25.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "input.h"
+
+static constexpr u8 INPUT_ACTION_COUNT = 4;
+enum class InputAction : u8 {
+  Quit = 0,
+  MemoryReport,
+  Jump,
+  ProfileCapture,
+  // When adding more variables, make sure to update INPUT_ACTION_COUNT and the names in
+  // InputActions.cpp
+};
+
+static constexpr u8 INPUT_AXIS_COUNT = 2;
+enum class InputAxis : u8 {
+  MoveX = 0,
+  MoveY,
+  // When adding more variables, make sure to update INPUT_AXIS_COUNT and the names in
+  // InputActions.cpp
+};
+
+/**
+ * Compiles the bindings of `configPath` into lookup tables indexed by key and mouse button. Falls
+ * back to the builtin bindings if the file can't be read.
+ *
+ * Config syntax, one binding per line, '#' starts a comment:
+ *   action <Action> key <Key>
+ *   action <Action> mouse <Button>
+ *   axis   <Axis>   key <Key> <scale>
+ */
+void input_actions_initialize(u64 *memorySize, void *pState, CString configPath);
+void input_actions_shutdown();
+
+// Replaces all bindings with the ones from the given config, returns false if it can't be read
+bool input_actions_load(CString path);
+void input_actions_clear();
+
+void input_actions_bind_key(InputAction action, Key key);
+void input_actions_bind_mouse_button(InputAction action, MouseButton button);
+// A key can drive at most one axis, binding it again replaces the previous axis binding
+void input_actions_bind_axis(InputAxis axis, Key key, f32 scale);
+
+// Evaluates all actions and axes in one pass, should be called once per frame after input was
+// polled
+void input_actions_update();
+
+// Action bitsets, bit `i` stands for `InputAction(i)`. A tap within a single frame is both pressed
+// and released that frame, even though the action was never down.
+u64 input_actions_get_down();
+u64 input_actions_get_pressed();
+u64 input_actions_get_released();
+
+bool input_action_is_down(InputAction action);
+bool input_action_pressed(InputAction action);
+bool input_action_released(InputAction action);
+
+f32 input_axis_get(InputAxis axis);
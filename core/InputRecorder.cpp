@@ -0,0 +1,197 @@
+//
+// Created by Hongjian Zhu on 2022/10/24.
+//
+
+#include "core/InputRecorder.h"
+#include "container/darray.h"
+#include "input.h"
+#include "logging.h"
+#include "memory.h"
+#include "platform.h"
+#include "platform/filesystem.h"
+#include <cstring>
+
+static constexpr u32 INPUT_RECORDING_VERSION = 1;
+static constexpr u64 INPUT_RECORD_FLUSH_SIZE = 1024; // Records buffered before writing to the file
+
+struct InputRecorderState {
+  InputRecorderMode mode;
+  FileHandle        file;
+  u32               frame;
+  f64               startTime;
+
+  InputRecord *pending; // DArray, records not yet written to the file
+
+  FileView           replay; // The mapped recording
+  const InputRecord *replayRecords;
+  u64                replayRecordCount;
+  u64                replayCursor;
+};
+
+static InputRecorderState *state = nullptr;
+
+static void flush_pending() {
+  u64 count = darray_length(state->pending);
+  if (count == 0) { return; }
+  u64 written = 0;
+  if (!filesystem_write(&state->file, count * sizeof(InputRecord), state->pending, &written)) {
+    LOGC_ERROR(Input, "[InputRecorder] Failed to write %llu records", count);
+  }
+  darray_clear(state->pending);
+}
+
+static bool open_recording(CString path) {
+  if (!filesystem_open(path, FILE_MODE_WRITE, true, &state->file)) {
+    LOGC_ERROR(Input, "[InputRecorder] Failed to create recording '%s'", path);
+    return false;
+  }
+  InputRecordingHeader header = {
+      .magic      = {'P', 'K', 'I', 'R'},
+      .version    = INPUT_RECORDING_VERSION,
+      .recordSize = sizeof(InputRecord),
+  };
+  u64 written = 0;
+  if (!filesystem_write(&state->file, sizeof(header), &header, &written)) {
+    filesystem_close(&state->file);
+    return false;
+  }
+  state->pending = DARRAY_RESERVE(InputRecord, INPUT_RECORD_FLUSH_SIZE, MemoryTag::Input);
+  return true;
+}
+
+static bool open_replay(CString path) {
+  if (!filesystem_map(path, &state->replay)) {
+    LOGC_ERROR(Input, "[InputRecorder] Failed to open recording '%s'", path);
+    return false;
+  }
+  if (state->replay.size < sizeof(InputRecordingHeader)) {
+    LOGC_ERROR(Input, "[InputRecorder] Failed to read recording '%s'", path);
+    return false;
+  }
+
+  auto header = (const InputRecordingHeader *) state->replay.data;
+  if (memcmp(header->magic, "PKIR", 4) != 0 || header->version != INPUT_RECORDING_VERSION ||
+      header->recordSize != sizeof(InputRecord)) {
+    LOGC_ERROR(Input, "[InputRecorder] '%s' is not a compatible input recording", path);
+    return false;
+  }
+
+  state->replayRecords     = (const InputRecord *) (state->replay.data + sizeof(*header));
+  state->replayRecordCount = (state->replay.size - sizeof(*header)) / sizeof(InputRecord);
+  state->replayCursor      = 0;
+  return true;
+}
+
+void input_recorder_initialize(u64              *memorySize,
+                               void             *pState,
+                               InputRecorderMode mode,
+                               CString           path) {
+  *memorySize = sizeof(InputRecorderState);
+  if (!pState) { return; }
+  state            = (InputRecorderState *) pState;
+  state->mode      = InputRecorderMode::Off;
+  state->startTime = platform_get_absolute_time();
+
+  if (mode == InputRecorderMode::Record && open_recording(path)) {
+    state->mode = mode;
+    LOGC_INFO(Input, "[InputRecorder] Recording input to '%s'", path);
+  } else if (mode == InputRecorderMode::Replay && open_replay(path)) {
+    state->mode = mode;
+    LOGC_INFO(Input,
+              "[InputRecorder] Replaying %llu records from '%s'",
+              state->replayRecordCount,
+              path);
+  }
+}
+
+void input_recorder_shutdown() {
+  if (!state) { return; }
+  if (state->mode == InputRecorderMode::Record) {
+    flush_pending();
+    darray_destroy(state->pending);
+    filesystem_close(&state->file);
+  }
+  filesystem_unmap(&state->replay);
+  state = nullptr;
+}
+
+bool input_recorder_is_recording() { return state && state->mode == InputRecorderMode::Record; }
+
+bool input_recorder_is_replaying() { return state && state->mode == InputRecorderMode::Replay; }
+
+bool input_recorder_sync_frame(f64 &time) {
+  if (input_recorder_is_recording()) {
+    InputRecord record = {.frame = state->frame, .type = (u8) InputRecordType::Frame, .time = time};
+    DARRAY_PUSH(state->pending, record);
+    if (darray_length(state->pending) >= INPUT_RECORD_FLUSH_SIZE) { flush_pending(); }
+    state->frame++;
+    return true;
+  }
+
+  if (!input_recorder_is_replaying()) { return true; }
+
+  while (state->replayCursor < state->replayRecordCount) {
+    const auto &record = state->replayRecords[state->replayCursor++];
+    switch ((InputRecordType) record.type) {
+    case InputRecordType::Frame:
+      time = record.time;
+      state->frame++;
+      return true;
+    case InputRecordType::Key:
+      input_process_key((Key) record.code, record.pressed);
+      break;
+    case InputRecordType::MouseButton:
+      input_process_mouse_button(record.code, record.pressed);
+      break;
+    case InputRecordType::MouseMove:
+      input_process_mouse_move(record.data.f32[0], record.data.f32[1]);
+      break;
+    case InputRecordType::MouseWheel:
+      input_process_mouse_wheel(record.data.f32[0], record.data.f32[1]);
+      break;
+    case InputRecordType::WindowResized:
+      // Not re-injected, the swapchain has to follow the size of the live surface
+      break;
+    case InputRecordType::ApplicationQuit:
+      event_fire(EventCode::ApplicationQuit, nullptr, {});
+      break;
+    }
+  }
+  LOGC_INFO(Input, "[InputRecorder] Replay finished after %u frames", state->frame);
+  return false;
+}
+
+void input_recorder_capture(InputRecordType type, u16 code, bool pressed, f32 x, f32 y) {
+  if (!input_recorder_is_recording()) { return; }
+  InputRecord record = {
+      .frame   = state->frame,
+      .type    = (u8) type,
+      .pressed = pressed,
+      .code    = code,
+      .time    = platform_get_absolute_time() - state->startTime,
+  };
+  record.data.f32[0] = x;
+  record.data.f32[1] = y;
+  DARRAY_PUSH(state->pending, record);
+}
+
+void input_recorder_capture_event(EventCode code, const EventContext &context) {
+  if (!input_recorder_is_recording()) { return; }
+  InputRecord record = {
+      .frame = state->frame,
+      .time  = platform_get_absolute_time() - state->startTime,
+  };
+  switch (code) {
+  case EventCode::WindowResized:
+    record.type        = (u8) InputRecordType::WindowResized;
+    record.data.u32[0] = context.u32[0];
+    record.data.u32[1] = context.u32[1];
+    break;
+  case EventCode::ApplicationQuit:
+    record.type = (u8) InputRecordType::ApplicationQuit;
+    break;
+  default:
+    return; // Input events are captured by the input system itself
+  }
+  DARRAY_PUSH(state->pending, record);
+}
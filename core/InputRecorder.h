@@ -0,0 +1,68 @@
+//
+// Created by Hongjian Zhu on 2022/10/24.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "event.h"
+
+enum class InputRecorderMode : u8 {
+  Off = 0,
+  Record, // Capture input and platform events into a recording file
+  Replay, // Feed a recording back through the input system, live input is ignored
+};
+
+enum class InputRecordType : u8 {
+  Frame = 0, // Marks the end of a frame's input, `time` holds the frame time
+  Key,
+  MouseButton,
+  MouseMove,
+  MouseWheel,
+  WindowResized,
+  ApplicationQuit,
+};
+
+// File layout:
+// InputRecordingHeader
+// InputRecord[]
+struct InputRecordingHeader {
+  char magic[4]; // "PKIR"
+  u32  version;
+  u32  recordSize;
+  u32  reserved;
+};
+
+struct InputRecord { // 24B
+  u32 frame;
+  u8  type;
+  u8  pressed;
+  u16 code;
+  f64 time; // Seconds since the recording started
+  union {
+    f32 f32[2];
+    u32 u32[2];
+  } data;
+};
+
+void input_recorder_initialize(u64              *memorySize,
+                               void             *pState,
+                               InputRecorderMode mode,
+                               CString           path);
+void input_recorder_shutdown();
+
+bool input_recorder_is_recording();
+bool input_recorder_is_replaying();
+
+/**
+ * Closes the input of the current frame. Should be called once per frame, after the platform events
+ * have been polled and before the simulation is updated.
+ * When recording, `time` is written to the recording. When replaying, the recorded input of the
+ * frame is dispatched through the input system and `time` is replaced by the recorded frame time.
+ * @param time The frame time in seconds.
+ * @return false if the replay has run out of recorded frames.
+ */
+bool input_recorder_sync_frame(f64 &time);
+
+void input_recorder_capture(InputRecordType type, u16 code, bool pressed, f32 x, f32 y);
+void input_recorder_capture_event(EventCode code, const EventContext &context);
@@ -0,0 +1,170 @@
+//
+// Created by Hongjian Zhu on 2022/10/27.
+//
+
+#include "core/LogFile.h"
+#include "platform.h"
+#include "platform/filesystem.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Must not log through the logging system, it's the one writing to us
+static void report_error(CString what, CString path) {
+  char message[512];
+  snprintf(message, sizeof(message), "[LogFile] %s '%s': %s\n", what, path, strerror(errno));
+  platform_console_write_error(message);
+}
+
+void log_file_rotate(CString path, u32 maxArchives) {
+  char from[512];
+  char to[512];
+  if (maxArchives == 0) {
+    filesystem_remove(path);
+    return;
+  }
+  snprintf(to, sizeof(to), "%s.%u", path, maxArchives);
+  filesystem_remove(to);
+  for (u32 i = maxArchives - 1; i > 0; --i) {
+    snprintf(from, sizeof(from), "%s.%u", path, i);
+    snprintf(to, sizeof(to), "%s.%u", path, i + 1);
+    if (filesystem_exists(from)) { filesystem_rename(from, to); }
+  }
+  snprintf(to, sizeof(to), "%s.1", path);
+  filesystem_rename(path, to);
+}
+
+bool LogFile::open(const LogFileConfig &config) {
+  _config = config;
+  if (!open_file()) { return false; }
+  if (should_rotate(0)) {
+    close_file();
+    log_file_rotate(_config.path, _config.maxArchives);
+    return open_file();
+  }
+  return true;
+}
+
+bool LogFile::open_file() {
+  _fd = ::open(_config.path, O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (_fd < 0) {
+    report_error("Failed to open", _config.path);
+    return false;
+  }
+  struct stat st {};
+  fstat(_fd, &st);
+  _size     = st.st_size;
+  _openedAt = time(nullptr);
+
+  if (_config.mapped) {
+    // A crash leaves the unused tail of the last mapping chunk as zeros, cut it off
+    u8  block[4 * KiB];
+    u64 end = _size;
+    while (end > 0) {
+      u64 length = end < sizeof(block) ? end : sizeof(block);
+      if (pread(_fd, block, length, (off_t) (end - length)) != (ssize_t) length) { break; }
+      u64 used = length;
+      while (used > 0 && block[used - 1] == 0) {
+        --used;
+      }
+      end -= length - used;
+      if (used > 0) { break; }
+    }
+    if (end != _size) {
+      ftruncate(_fd, (off_t) end);
+      _size = end;
+    }
+  }
+  return true;
+}
+
+void LogFile::close_file() {
+  if (_fd < 0) { return; }
+  flush();
+  if (_mapping) {
+    munmap(_mapping, _mappingSize);
+    ftruncate(_fd, (off_t) _size); // Drop the unused part of the last chunk
+    _mapping     = nullptr;
+    _mappingSize = 0;
+  }
+  ::close(_fd);
+  _fd = -1;
+}
+
+void LogFile::close() { close_file(); }
+
+bool LogFile::should_rotate(u64 incoming) const {
+  u64 size = _size + _bufferLength;
+  if (_config.maxSize > 0 && size > 0 && size + incoming > _config.maxSize) { return true; }
+  return _config.maxAgeSeconds > 0 && time(nullptr) - _openedAt >= _config.maxAgeSeconds;
+}
+
+bool LogFile::map(u64 size) {
+  u64 mappingSize = (size + LOG_FILE_MAP_CHUNK - 1) / LOG_FILE_MAP_CHUNK * LOG_FILE_MAP_CHUNK;
+  if (_mapping) { munmap(_mapping, _mappingSize); }
+  _mapping     = nullptr;
+  _mappingSize = 0;
+  if (ftruncate(_fd, (off_t) mappingSize) != 0) {
+    report_error("Failed to grow", _config.path);
+    return false;
+  }
+  auto mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (mapping == MAP_FAILED) {
+    report_error("Failed to map", _config.path);
+    ftruncate(_fd, (off_t) _size);
+    return false;
+  }
+  _mapping     = (u8 *) mapping;
+  _mappingSize = mappingSize;
+  return true;
+}
+
+void LogFile::write(const void *data, u64 size) {
+  if (_fd < 0) { return; }
+  if (should_rotate(size)) {
+    close_file();
+    log_file_rotate(_config.path, _config.maxArchives);
+    if (!open_file()) { return; }
+  }
+
+  if (_config.mapped) {
+    if (_size + size <= _mappingSize || map(_size + size)) {
+      memcpy(_mapping + _size, data, size);
+      _size += size;
+      return;
+    }
+    _config.mapped = false; // Keep logging through the buffer
+  }
+
+  if (_bufferLength + size > LOG_FILE_BUFFER_SIZE) { flush(); }
+  if (size > LOG_FILE_BUFFER_SIZE) {
+    // Too big to buffer, goes straight to the file
+    for (u64 offset = 0; offset < size;) {
+      auto written = ::write(_fd, (const u8 *) data + offset, size - offset);
+      if (written <= 0) { break; }
+      offset += written;
+      _size += written;
+    }
+    return;
+  }
+  memcpy(_buffer + _bufferLength, data, size);
+  _bufferLength += size;
+}
+
+void LogFile::flush() {
+  if (_fd < 0) { return; }
+  u64 offset = 0;
+  while (offset < _bufferLength) {
+    auto written = ::write(_fd, _buffer + offset, _bufferLength - offset);
+    if (written < 0 && errno == EINTR) { continue; }
+    if (written <= 0) { break; }
+    offset += written;
+  }
+  _size += offset;
+  _bufferLength = 0;
+}
@@ -0,0 +1,61 @@
+//
+// Created by Hongjian Zhu on 2022/10/27.
+//
+
+#pragma once
+
+#include "defines.h"
+
+static constexpr u64 LOG_FILE_BUFFER_SIZE = 64 * KiB;
+static constexpr u64 LOG_FILE_MAP_CHUNK   = 4 * MiB; // Mapped files grow by this much at a time
+
+struct LogFileConfig {
+  CString path;
+  // Rotate once the file would grow past this many bytes, 0 disables size based rotation
+  u64 maxSize;
+  // Rotate once the file has been open for this long, 0 disables time based rotation
+  u32 maxAgeSeconds;
+  // Rotated files are kept as "<path>.1" (newest) to "<path>.<maxArchives>", older ones are deleted
+  u32 maxArchives;
+  // Write through a shared memory mapping instead of write(2), the page cache then holds the
+  // data and nothing is lost if the process crashes
+  bool mapped;
+};
+
+// Shifts "<path>" to "<path>.1", "<path>.1" to "<path>.2" and so on, dropping the oldest archive
+void log_file_rotate(CString path, u32 maxArchives);
+
+// Append-only log file which writes in large blocks and rotates itself. Not thread safe.
+class LogFile {
+public:
+  // Appends to an existing file, rotating it first if it's already over the limits
+  bool open(const LogFileConfig &config);
+
+  void write(const void *data, u64 size);
+
+  // Writes out the buffered data
+  void flush();
+
+  void close();
+
+  bool is_open() const { return _fd >= 0; }
+
+  // For appending with write(2) where nothing else is safe, e.g. a crash handler. -1 if the file
+  // is written through a mapping, appending would land past the mapped end.
+  i32 append_fd() const { return _config.mapped ? -1 : _fd; }
+
+private:
+  bool open_file();
+  void close_file();
+  bool should_rotate(u64 incoming) const;
+  bool map(u64 size);
+
+  LogFileConfig _config       = {};
+  i32           _fd           = -1;
+  u64           _size         = 0; // Bytes in the file, not counting the buffer
+  i64           _openedAt     = 0; // Seconds since the epoch
+  u8           *_mapping      = nullptr;
+  u64           _mappingSize  = 0;
+  u64           _bufferLength = 0;
+  u8            _buffer[LOG_FILE_BUFFER_SIZE];
+};
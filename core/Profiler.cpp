@@ -0,0 +1,252 @@
+//
+// Created by Hongjian Zhu on 2022/11/3.
+//
+
+#include "core/Profiler.h"
+#include "logging.h"
+#include "memory.h"
+#include "platform/filesystem.h"
+#include "platform/timer.h"
+#include <cstdarg>
+#include <cstdio>
+#include <new>
+
+static_assert((PROFILER_THREAD_ZONES & (PROFILER_THREAD_ZONES - 1)) == 0);
+static_assert((PROFILER_FRAME_CAPACITY & (PROFILER_FRAME_CAPACITY - 1)) == 0);
+
+struct Zone {
+  CString name;
+  u64     start;
+  u64     end;
+};
+
+struct ThreadZones {
+  std::atomic<u64>     head; // Zones written so far, the ring keeps the last PROFILER_THREAD_ZONES
+  std::atomic<bool>    ready;
+  std::atomic<CString> name;
+  Zone                *zones;
+};
+
+struct ProfilerState {
+  ThreadZones      threads[PROFILER_MAX_THREADS];
+  std::atomic<u32> threadCount;
+  u64              frames[PROFILER_FRAME_CAPACITY]; // Frame start times
+  u64              frameCount;
+  Zone            *exportZones; // Scratch for copying a ring out
+};
+
+static ProfilerState *state = nullptr;
+
+std::atomic<bool> profilerEnabled = false;
+
+static thread_local ThreadZones *threadZones = nullptr;
+static thread_local bool         noSlotLeft  = false;
+static thread_local CString      threadName  = nullptr;
+
+static i32 acquire_slot(CString name) {
+  u32 index = state->threadCount.fetch_add(1, std::memory_order_relaxed);
+  if (index >= PROFILER_MAX_THREADS) { return -1; }
+  state->threads[index].name.store(name, std::memory_order_relaxed);
+  state->threads[index].ready.store(true, std::memory_order_release);
+  return (i32) index;
+}
+
+static ThreadZones *acquire_thread_zones() {
+  if (threadZones || noSlotLeft || !state) { return threadZones; }
+  i32 index = acquire_slot(threadName);
+  if (index < 0) {
+    noSlotLeft = true;
+    return nullptr;
+  }
+  threadZones = &state->threads[index];
+  return threadZones;
+}
+
+static void write_zone(ThreadZones *zones, CString name, u64 start, u64 end) {
+  u64 head = zones->head.load(std::memory_order_relaxed);
+  zones->zones[head & (PROFILER_THREAD_ZONES - 1)] = {name, start, end};
+  zones->head.store(head + 1, std::memory_order_release);
+}
+
+void profiler_initialize(u64 *memorySize, void *pState, const ProfilerConfig &config) {
+  *memorySize = sizeof(ProfilerState);
+  if (!pState) { return; }
+  state = new (pState) ProfilerState();
+  if (!config.enabled) { return; }
+
+  for (auto &thread : state->threads) {
+    thread.zones = MEMORY_ALLOCATE(Zone, PROFILER_THREAD_ZONES, MemoryTag::Profiler);
+  }
+  state->exportZones = MEMORY_ALLOCATE(Zone, PROFILER_THREAD_ZONES, MemoryTag::Profiler);
+  profilerEnabled.store(true, std::memory_order_relaxed);
+  LOGC_INFO(General, "[Profiler] Recording, %u zones kept per thread", PROFILER_THREAD_ZONES);
+}
+
+void profiler_shutdown() {
+  if (!state) { return; }
+  bool enabled = profilerEnabled.exchange(false);
+  if (enabled) {
+    for (auto &thread : state->threads) {
+      MEMORY_FREE(thread.zones, Zone, PROFILER_THREAD_ZONES, MemoryTag::Profiler);
+    }
+    MEMORY_FREE(state->exportZones, Zone, PROFILER_THREAD_ZONES, MemoryTag::Profiler);
+  }
+  state->~ProfilerState();
+  state = nullptr;
+}
+
+void profiler_set_thread_name(CString name) {
+  threadName = name; // Threads get their track on their first zone
+  if (threadZones) { threadZones->name.store(name, std::memory_order_relaxed); }
+}
+
+void profiler_frame_mark() {
+  if (!profiler_is_enabled()) { return; }
+  state->frames[state->frameCount++ & (PROFILER_FRAME_CAPACITY - 1)] = platform_get_time_ns();
+}
+
+void profiler_record_zone(CString name, u64 start, u64 end) {
+  if (auto zones = acquire_thread_zones()) { write_zone(zones, name, start, end); }
+}
+
+i32 profiler_create_track(CString name) {
+  if (!profiler_is_enabled()) { return -1; }
+  return acquire_slot(name);
+}
+
+void profiler_record_track_zone(i32 track, CString name, u64 start, u64 end) {
+  if (track < 0 || !profiler_is_enabled()) { return; }
+  write_zone(&state->threads[track], name, start, end);
+}
+
+// Buffers the JSON and writes it out in large chunks
+struct TraceWriter {
+  FileHandle file;
+  char       buffer[16 * KiB];
+  u64        used;
+  bool       failed;
+};
+
+static void trace_flush(TraceWriter *writer) {
+  u64 written = 0;
+  if (writer->used && !filesystem_write(&writer->file, writer->used, writer->buffer, &written)) {
+    writer->failed = true;
+  }
+  writer->used = 0;
+}
+
+static void trace_write(TraceWriter *writer, const char *format, ...) {
+  for (u32 attempt = 0; attempt < 2; ++attempt) {
+    va_list args;
+    va_start(args, format);
+    u64 left = sizeof(writer->buffer) - writer->used;
+    i32 n    = vsnprintf(writer->buffer + writer->used, left, format, args);
+    va_end(args);
+    if (n >= 0 && (u64) n < left) {
+      writer->used += n;
+      return;
+    }
+    trace_flush(writer); // Didn't fit, retry with an empty buffer
+  }
+  writer->failed = true;
+}
+
+// Copies the zones still in the ring, returns how many starting at `*first` survived the copy
+static u64 copy_thread_zones(ThreadZones *thread, Zone *dst, u64 *first) {
+  u64 head  = thread->head.load(std::memory_order_acquire);
+  u64 begin = head > PROFILER_THREAD_ZONES ? head - PROFILER_THREAD_ZONES : 0;
+  for (u64 i = begin; i < head; ++i) {
+    dst[i & (PROFILER_THREAD_ZONES - 1)] = thread->zones[i & (PROFILER_THREAD_ZONES - 1)];
+  }
+  // The owner kept writing, anything it has wrapped around onto since may be torn. That includes
+  // the slot of zone `after`, which it may be writing right now.
+  u64 after = thread->head.load(std::memory_order_acquire);
+  if (after + 1 > begin + PROFILER_THREAD_ZONES) { begin = after + 1 - PROFILER_THREAD_ZONES; }
+  *first = begin;
+  return head > begin ? head - begin : 0;
+}
+
+bool profiler_export_chrome_trace(CString path, u32 frameCount) {
+  if (!profiler_is_enabled()) { return false; }
+
+  // The newest mark starts the frame in progress, only the ones before it are complete
+  u64 marks = state->frameCount;
+  if (marks < 2) {
+    LOGC_WARN(General, "[Profiler] No complete frame to export yet");
+    return false;
+  }
+  u64 available   = marks > PROFILER_FRAME_CAPACITY ? PROFILER_FRAME_CAPACITY - 1 : marks - 1;
+  frameCount      = frameCount < available ? frameCount : (u32) available;
+  u64 lastMark    = marks - 1;
+  u64 firstMark   = lastMark - frameCount;
+  u64 windowStart = state->frames[firstMark & (PROFILER_FRAME_CAPACITY - 1)];
+  u64 windowEnd   = state->frames[lastMark & (PROFILER_FRAME_CAPACITY - 1)];
+
+  auto to_us = [windowStart](u64 time) { return (f64) (time - windowStart) * 1e-3; };
+
+  auto writer = new TraceWriter();
+  if (!filesystem_open(path, FILE_MODE_WRITE, false, &writer->file)) {
+    LOGC_ERROR(General, "[Profiler] Failed to open '%s'", path);
+    delete writer;
+    return false;
+  }
+
+  trace_write(writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  trace_write(writer,
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+              "\"args\":{\"name\":\"Frames\"}}");
+  for (u64 i = firstMark; i < lastMark; ++i) {
+    u64 start = state->frames[i & (PROFILER_FRAME_CAPACITY - 1)];
+    u64 end   = state->frames[(i + 1) & (PROFILER_FRAME_CAPACITY - 1)];
+    trace_write(writer,
+                ",\n{\"name\":\"Frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":0,"
+                "\"ts\":%.3f,\"dur\":%.3f}",
+                (unsigned long long) i,
+                to_us(start),
+                (f64) (end - start) * 1e-3);
+  }
+
+  u64 zoneCount   = 0;
+  u32 threadCount = state->threadCount.load(std::memory_order_relaxed);
+  threadCount     = threadCount < PROFILER_MAX_THREADS ? threadCount : PROFILER_MAX_THREADS;
+  for (u32 t = 0; t < threadCount; ++t) {
+    auto thread = &state->threads[t];
+    if (!thread->ready.load(std::memory_order_acquire)) { continue; }
+    CString name = thread->name.load(std::memory_order_relaxed);
+    trace_write(writer,
+                ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"%s\"}}",
+                t + 1,
+                name ? name : "Thread");
+
+    u64 first = 0;
+    u64 count = copy_thread_zones(thread, state->exportZones, &first);
+    for (u64 i = first; i < first + count; ++i) {
+      auto &zone = state->exportZones[i & (PROFILER_THREAD_ZONES - 1)];
+      if (zone.start < windowStart || zone.start >= windowEnd) { continue; }
+      trace_write(writer,
+                  ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                  zone.name,
+                  t + 1,
+                  to_us(zone.start),
+                  (f64) (zone.end - zone.start) * 1e-3);
+      ++zoneCount;
+    }
+  }
+  trace_write(writer, "\n]}\n");
+  trace_flush(writer);
+  filesystem_close(&writer->file);
+
+  bool ok = !writer->failed;
+  delete writer;
+  if (!ok) {
+    LOGC_ERROR(General, "[Profiler] Failed to write '%s'", path);
+    return false;
+  }
+  LOGC_INFO(General,
+            "[Profiler] Wrote %u frames, %llu zones to '%s'",
+            frameCount,
+            (unsigned long long) zoneCount,
+            path);
+  return true;
+}
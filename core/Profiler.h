@@ -0,0 +1,86 @@
+//
+// Created by Hongjian Zhu on 2022/11/3.
+//
+
+#pragma once
+
+#include "defines.h"
+#include "platform/perf_counters.h"
+#include "platform/timer.h"
+#include <atomic>
+
+// Set to 0 to compile every PROFILE_SCOPE out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+static constexpr u32 PROFILER_MAX_THREADS    = 32;    // Tracks created share the slots
+static constexpr u32 PROFILER_THREAD_ZONES   = 16384; // Kept per thread, must be a power of two
+static constexpr u32 PROFILER_FRAME_CAPACITY = 1024;  // Frame boundaries kept, a power of two
+
+struct ProfilerConfig {
+  bool enabled; // Zones cost a relaxed load and a branch until enabled
+};
+
+/**
+ * Zones are recorded into a ring per thread, with the latest `PROFILER_THREAD_ZONES` kept, so the
+ * recent frames can be written out at any time. Recording doesn't lock, each ring has a single
+ * writer and readers discard whatever got overwritten while they copied it.
+ */
+void profiler_initialize(u64 *memorySize, void *pState, const ProfilerConfig &config = {});
+void profiler_shutdown();
+
+extern std::atomic<bool> profilerEnabled;
+
+inline bool profiler_is_enabled() { return profilerEnabled.load(std::memory_order_relaxed); }
+
+// Names the calling thread's track in exported traces, `name` must outlive the profiler
+void profiler_set_thread_name(CString name);
+
+// Called at the start of every frame on the main thread
+void profiler_frame_mark();
+
+// Writes the last `frameCount` complete frames as Chrome trace JSON, which both chrome://tracing
+// and Perfetto open. Call from the main thread.
+bool profiler_export_chrome_trace(CString path, u32 frameCount);
+
+// Records a zone on the calling thread's track, see ProfileZone
+void profiler_record_zone(CString name, u64 start, u64 end);
+
+// A track for zones that didn't run on a CPU thread, e.g. GPU work read back later. Only one
+// thread may record into a given track. Returns -1 when all tracks are taken.
+i32  profiler_create_track(CString name);
+void profiler_record_track_zone(i32 track, CString name, u64 start, u64 end);
+
+class ProfileZone {
+public:
+  // `name` must be a string literal, only the pointer is stored
+  explicit ProfileZone(CString name) : _name(name), _start(0) {
+    if (profiler_is_enabled()) { _start = platform_get_time_ns(); }
+    // Read last, so the counters leave out the zone's own bookkeeping
+    _counting = perf_counters_zones_enabled() && perf_counters_read(&_counters);
+  }
+  ~ProfileZone() {
+    if (_counting) { perf_counters_record_zone(_name, _counters); }
+    if (_start) { profiler_record_zone(_name, _start, platform_get_time_ns()); }
+  }
+
+  ProfileZone(const ProfileZone &)            = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+  CString      _name;
+  u64          _start; // 0 when the profiler is off
+  bool         _counting;
+  PerfCounters _counters;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if PROFILER_ENABLED
+// Records the enclosing scope as a zone named `name`, zones nest by scope
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,71 @@
+//
+// Created by Hongjian Zhu on 2022/10/28.
+//
+
+#include "core/ThreadPool.h"
+#include "core/Profiler.h"
+#include "platform/perf_counters.h"
+
+bool ThreadPool::start(u32 threadCount) {
+  if (threadCount == 0) {
+    u32 cores   = std::thread::hardware_concurrency();
+    threadCount = cores > 1 ? cores - 1 : 1;
+  }
+  threadCount  = threadCount < THREAD_POOL_MAX_THREADS ? threadCount : THREAD_POOL_MAX_THREADS;
+  _stopping    = false;
+  _threadCount = threadCount;
+  for (u32 i = 0; i < threadCount; ++i) {
+    _threads[i] = std::thread(&ThreadPool::worker_main, this);
+  }
+  return true;
+}
+
+void ThreadPool::stop() {
+  {
+    std::lock_guard guard(_mutex);
+    _stopping = true;
+  }
+  _jobAvailable.notify_all();
+  for (u32 i = 0; i < _threadCount; ++i) {
+    _threads[i].join();
+  }
+  _threadCount = 0;
+}
+
+void ThreadPool::submit(PFN_job job, void *data) {
+  {
+    std::unique_lock lock(_mutex);
+    _slotAvailable.wait(lock, [this] { return _tail - _head < THREAD_POOL_QUEUE_SIZE; });
+    _jobs[_tail++ & (THREAD_POOL_QUEUE_SIZE - 1)] = {job, data};
+  }
+  _jobAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock lock(_mutex);
+  _idle.wait(lock, [this] { return _head == _tail && _running == 0; });
+}
+
+void ThreadPool::worker_main() {
+  profiler_set_thread_name("ThreadPool");
+  perf_counters_attach_thread();
+  std::unique_lock lock(_mutex);
+  for (;;) {
+    _jobAvailable.wait(lock, [this] { return _head != _tail || _stopping; });
+    if (_head == _tail) { // Stopping and nothing left to do
+      perf_counters_detach_thread();
+      return;
+    }
+
+    Job job = _jobs[_head++ & (THREAD_POOL_QUEUE_SIZE - 1)];
+    ++_running;
+    lock.unlock();
+    _slotAvailable.notify_one();
+
+    job.function(job.data);
+
+    lock.lock();
+    --_running;
+    if (_head == _tail && _running == 0) { _idle.notify_all(); }
+  }
+}
@@ -0,0 +1,53 @@
+//
+// Created by Hongjian Zhu on 2022/10/28.
+//
+
+#pragma once
+
+#include "defines.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static constexpr u32 THREAD_POOL_MAX_THREADS = 16;
+static constexpr u32 THREAD_POOL_QUEUE_SIZE  = 1024; // Must be a power of two
+
+typedef void (*PFN_job)(void *data);
+
+// Fixed set of worker threads running jobs from a bounded FIFO queue
+class ThreadPool {
+public:
+  // A `threadCount` of 0 uses one thread per core, minus one for the main thread
+  bool start(u32 threadCount = 0);
+
+  // Runs the queued jobs to completion, then joins the workers
+  void stop();
+
+  // Blocks while the queue is full
+  void submit(PFN_job job, void *data);
+
+  // Blocks until the queue is empty and no job is running
+  void wait();
+
+  u32 thread_count() const { return _threadCount; }
+
+private:
+  struct Job {
+    PFN_job function;
+    void   *data;
+  };
+
+  void worker_main();
+
+  std::thread             _threads[THREAD_POOL_MAX_THREADS];
+  u32                     _threadCount = 0;
+  bool                    _stopping    = false;
+  std::mutex              _mutex;
+  std::condition_variable _jobAvailable;
+  std::condition_variable _slotAvailable;
+  std::condition_variable _idle;
+  Job                     _jobs[THREAD_POOL_QUEUE_SIZE];
+  u64                     _head    = 0; // Next job to run
+  u64                     _tail    = 0; // Next free slot
+  u32                     _running = 0; // Jobs taken off the queue but not finished yet
+};
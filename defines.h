@@ -50,6 +50,8 @@ void report_assertion_failure(CString expression, CString message, CString file,
 #elif TARGET_IPHONE_SIMULATOR
 #define PLATFORM_IOS_SIMULATOR 1
 #endif
+#elif defined(__linux__)
+#define PLATFORM_LINUX 1
 #else
 #error "Unknown platform"
 #endif
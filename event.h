@@ -21,7 +21,7 @@ union EventContext { // 128B
   char c[16];
 };
 
-static constexpr u16 EVENT_CODE_COUNT = 11;
+static constexpr u16 EVENT_CODE_COUNT = 14;
 enum class EventCode : u16 {
   Unknown = 0x00,
   ApplicationQuit,
@@ -45,6 +45,17 @@ enum class EventCode : u16 {
   // f32 xOffset = .f32[0];
   // f32 yOffset = .f32[1];
   MouseWheeled,
+  // Context usage:
+  // u32 requestId = .u32[0];
+  // i32 error     = .i32[1];
+  // u64 bytesRead = .u64[1];
+  FileReadCompleted,
+  // Context usage:
+  // u32 changeId = .u32[0]; Pass to `file_watcher_get_path`
+  FileChanged,
+  // Context usage:
+  // bool focused = .u8[0];
+  WindowFocused,
   // When adding more variables, make sure to update EVENT_CODE_COUNT
 };
 
@@ -3,18 +3,28 @@
 //
 
 #include "input.h"
+#include "core/InputRecorder.h"
 #include "event.h"
 #include "logging.h"
 #include "memory.h"
+#include "platform.h"
 
-struct KeyboardState {
-  bool keys[512];
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static constexpr u32 KEY_WORD_COUNT = KEY_COUNT / 64;
+
+struct KeyboardState { // One bit per key
+  u64 keys[KEY_WORD_COUNT];
 };
 
 struct MouseState {
-  f32  x;
-  f32  y;
-  bool buttons[16];
+  f32 x;
+  f32 y;
+  u64 buttons; // One bit per button
 };
 
 struct InputSystemState {
@@ -22,10 +32,96 @@ struct InputSystemState {
   KeyboardState keyboardPrevious;
   MouseState    mouseCurrent;
   MouseState    mousePrevious;
+
+  // Edges between the previous and the current state, rebuilt lazily when `edgesDirty` is set
+  KeyboardState keyboardPressed;
+  KeyboardState keyboardReleased;
+  u64           mousePressed;
+  u64           mouseReleased;
+  bool          edgesDirty;
+
+  // Ring of raw samples, `sampleHead` counts all samples ever received
+  InputSample samples[INPUT_SAMPLE_CAPACITY];
+  u64         sampleHead;
+  u64         frameSampleStart; // `sampleHead` at the last `input_update`
+  f64         latchTime;
+  f32         latchedMouseX;
+  f32         latchedMouseY;
 };
 
 static InputSystemState *state = nullptr;
 
+static inline bool bit_test(const u64 *bits, u32 index) {
+  return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void bit_assign(u64 *bits, u32 index, bool value) {
+  u64 mask = 1ull << (index & 63);
+  if (value) {
+    bits[index >> 6] |= mask;
+  } else {
+    bits[index >> 6] &= ~mask;
+  }
+}
+
+static void update_edges() {
+  if (!state->edgesDirty) { return; }
+
+  const u64 *current  = state->keyboardCurrent.keys;
+  const u64 *previous = state->keyboardPrevious.keys;
+  u64       *pressed  = state->keyboardPressed.keys;
+  u64       *released = state->keyboardReleased.keys;
+  // pressed = current & ~previous, released = previous & ~current
+#if defined(__SSE2__)
+  for (u32 i = 0; i < KEY_WORD_COUNT; i += 2) {
+    __m128i c = _mm_loadu_si128((const __m128i *) (current + i));
+    __m128i p = _mm_loadu_si128((const __m128i *) (previous + i));
+    _mm_storeu_si128((__m128i *) (pressed + i), _mm_andnot_si128(p, c));
+    _mm_storeu_si128((__m128i *) (released + i), _mm_andnot_si128(c, p));
+  }
+#elif defined(__ARM_NEON)
+  for (u32 i = 0; i < KEY_WORD_COUNT; i += 2) {
+    uint64x2_t c = vld1q_u64(current + i);
+    uint64x2_t p = vld1q_u64(previous + i);
+    vst1q_u64(pressed + i, vbicq_u64(c, p));
+    vst1q_u64(released + i, vbicq_u64(p, c));
+  }
+#else
+  for (u32 i = 0; i < KEY_WORD_COUNT; ++i) {
+    pressed[i]  = current[i] & ~previous[i];
+    released[i] = previous[i] & ~current[i];
+  }
+#endif
+
+  state->mousePressed  = state->mouseCurrent.buttons & ~state->mousePrevious.buttons;
+  state->mouseReleased = state->mousePrevious.buttons & ~state->mouseCurrent.buttons;
+  state->edgesDirty    = false;
+}
+
+static void push_sample(InputSampleType type, u16 code, bool pressed, f32 x, f32 y) {
+  auto &sample   = state->samples[state->sampleHead++ & (INPUT_SAMPLE_CAPACITY - 1)];
+  sample.time    = platform_get_absolute_time();
+  sample.type    = type;
+  sample.pressed = pressed;
+  sample.code    = code;
+  sample.x       = x;
+  sample.y       = y;
+}
+
+// Writes the indices of the set bits to `out`, returns the number written
+template <typename T>
+static u32 collect_bits(const u64 *words, u32 wordCount, T *out, u32 capacity) {
+  u32 count = 0;
+  for (u32 w = 0; w < wordCount; ++w) {
+    u64 bits = words[w];
+    while (bits && count < capacity) {
+      out[count++] = (T) (w * 64 + __builtin_ctzll(bits));
+      bits &= bits - 1; // Clear the lowest set bit
+    }
+  }
+  return count;
+}
+
 void input_system_initialize(u64 *memorySize, void *pState) {
   *memorySize = sizeof(InputSystemState);
   if (!pState) { return; }
@@ -36,22 +132,90 @@ void input_system_shutdown() {}
 
 void input_update() {
   // Copy current states to previous states
-  memory_copy(&state->keyboardPrevious, &state->keyboardCurrent, sizeof(KeyboardState));
-  memory_copy(&state->mousePrevious, &state->mouseCurrent, sizeof(MouseState));
+  state->keyboardPrevious = state->keyboardCurrent;
+  state->mousePrevious    = state->mouseCurrent;
+  state->edgesDirty       = true;
+  state->frameSampleStart = state->sampleHead;
+  state->latchTime        = 0;
 }
 
-bool input_is_key_down(Key key) { return state->keyboardCurrent.keys[(u16) key]; }
+u32 input_get_frame_samples(InputSample *samples, u32 capacity) {
+  u64 first = state->frameSampleStart;
+  if (state->sampleHead - first > INPUT_SAMPLE_CAPACITY) { // Oldest samples were overwritten
+    first = state->sampleHead - INPUT_SAMPLE_CAPACITY;
+  }
+  u32 count = 0;
+  for (u64 i = first; i < state->sampleHead && count < capacity; ++i) {
+    samples[count++] = state->samples[i & (INPUT_SAMPLE_CAPACITY - 1)];
+  }
+  return count;
+}
 
-bool input_is_key_up(Key key) { return !state->keyboardCurrent.keys[(u16) key]; }
+void input_late_latch() {
+  state->latchTime = platform_get_absolute_time();
+  if (input_recorder_is_replaying() ||
+      !platform_sample_cursor(state->latchedMouseX, state->latchedMouseY)) {
+    state->latchedMouseX = state->mouseCurrent.x;
+    state->latchedMouseY = state->mouseCurrent.y;
+  }
+}
 
-bool input_was_key_down(Key key) { return state->keyboardPrevious.keys[(u16) key]; }
+void input_get_latched_mouse_position(f32 &x, f32 &y) {
+  if (state->latchTime == 0) {
+    input_get_mouse_position(x, y);
+    return;
+  }
+  x = state->latchedMouseX;
+  y = state->latchedMouseY;
+}
 
-bool input_was_key_up(Key key) { return !state->keyboardPrevious.keys[(u16) key]; }
+f64 input_get_latch_time() { return state->latchTime; }
+
+f64 input_get_latest_sample_time() {
+  if (state->sampleHead == state->frameSampleStart) { return 0; }
+  return state->samples[(state->sampleHead - 1) & (INPUT_SAMPLE_CAPACITY - 1)].time;
+}
+
+bool input_is_key_down(Key key) { return bit_test(state->keyboardCurrent.keys, (u16) key); }
+
+bool input_is_key_up(Key key) { return !bit_test(state->keyboardCurrent.keys, (u16) key); }
+
+bool input_was_key_down(Key key) { return bit_test(state->keyboardPrevious.keys, (u16) key); }
+
+bool input_was_key_up(Key key) { return !bit_test(state->keyboardPrevious.keys, (u16) key); }
+
+bool input_is_key_pressed_this_frame(Key key) {
+  update_edges();
+  return bit_test(state->keyboardPressed.keys, (u16) key);
+}
+
+bool input_is_key_released_this_frame(Key key) {
+  update_edges();
+  return bit_test(state->keyboardReleased.keys, (u16) key);
+}
+
+u32 input_get_keys_pressed_this_frame(Key *keys, u32 capacity) {
+  update_edges();
+  return collect_bits(state->keyboardPressed.keys, KEY_WORD_COUNT, keys, capacity);
+}
+
+u32 input_get_keys_released_this_frame(Key *keys, u32 capacity) {
+  update_edges();
+  return collect_bits(state->keyboardReleased.keys, KEY_WORD_COUNT, keys, capacity);
+}
+
+u32 input_get_keys_down(Key *keys, u32 capacity) {
+  return collect_bits(state->keyboardCurrent.keys, KEY_WORD_COUNT, keys, capacity);
+}
 
 void input_process_key(Key key, bool pressed) {
+  input_recorder_capture(InputRecordType::Key, (u16) key, pressed, 0, 0);
+  push_sample(InputSampleType::Key, (u16) key, pressed, 0, 0);
+  if ((u16) key >= KEY_COUNT) { return; }
   // Only handled if the state actually changed
-  if (state->keyboardCurrent.keys[(u16) key] != pressed) {
-    state->keyboardCurrent.keys[(u16) key] = pressed; // Update internal state
+  if (bit_test(state->keyboardCurrent.keys, (u16) key) != pressed) {
+    bit_assign(state->keyboardCurrent.keys, (u16) key, pressed); // Update internal state
+    state->edgesDirty = true;
     // Fire off an event for immediate processing
     EventContext context = {};
     context.u16[0]       = (u16) key;
@@ -59,15 +223,45 @@ void input_process_key(Key key, bool pressed) {
   }
 }
 
-bool input_is_mouse_button_down(MouseButton button) { return state->mouseCurrent.buttons[button]; }
+bool input_is_mouse_button_down(MouseButton button) {
+  return bit_test(&state->mouseCurrent.buttons, button);
+}
 
-bool input_is_mouse_button_up(MouseButton button) { return !state->mouseCurrent.buttons[button]; }
+bool input_is_mouse_button_up(MouseButton button) {
+  return !bit_test(&state->mouseCurrent.buttons, button);
+}
 
 bool input_was_mouse_button_down(MouseButton button) {
-  return state->mousePrevious.buttons[button];
+  return bit_test(&state->mousePrevious.buttons, button);
+}
+
+bool input_was_mouse_button_up(MouseButton button) {
+  return !bit_test(&state->mousePrevious.buttons, button);
+}
+
+bool input_is_mouse_button_pressed_this_frame(MouseButton button) {
+  update_edges();
+  return bit_test(&state->mousePressed, button);
 }
 
-bool input_was_mouse_button_up(MouseButton button) { return !state->mousePrevious.buttons[button]; }
+bool input_is_mouse_button_released_this_frame(MouseButton button) {
+  update_edges();
+  return bit_test(&state->mouseReleased, button);
+}
+
+u32 input_get_mouse_buttons_pressed_this_frame(MouseButton *buttons, u32 capacity) {
+  update_edges();
+  return collect_bits(&state->mousePressed, 1, buttons, capacity);
+}
+
+u32 input_get_mouse_buttons_released_this_frame(MouseButton *buttons, u32 capacity) {
+  update_edges();
+  return collect_bits(&state->mouseReleased, 1, buttons, capacity);
+}
+
+u32 input_get_mouse_buttons_down(MouseButton *buttons, u32 capacity) {
+  return collect_bits(&state->mouseCurrent.buttons, 1, buttons, capacity);
+}
 
 void input_get_mouse_position(f32 &x, f32 &y) {
   x = state->mouseCurrent.x;
@@ -80,8 +274,12 @@ void input_get_previous_mouse_position(f32 &x, f32 &y) {
 }
 
 void input_process_mouse_button(MouseButton button, bool pressed) {
-  if (state->mouseCurrent.buttons[button] != pressed) {
-    state->mouseCurrent.buttons[button] = pressed;
+  input_recorder_capture(InputRecordType::MouseButton, button, pressed, 0, 0);
+  push_sample(InputSampleType::MouseButton, button, pressed, 0, 0);
+  if (button >= MOUSE_BUTTON_COUNT) { return; }
+  if (bit_test(&state->mouseCurrent.buttons, button) != pressed) {
+    bit_assign(&state->mouseCurrent.buttons, button, pressed);
+    state->edgesDirty = true;
 
     EventContext context = {};
     context.u16[0]       = button;
@@ -91,8 +289,10 @@ void input_process_mouse_button(MouseButton button, bool pressed) {
 }
 
 void input_process_mouse_move(f32 x, f32 y) {
+  input_recorder_capture(InputRecordType::MouseMove, 0, false, x, y);
+  push_sample(InputSampleType::MouseMove, 0, false, x, y);
   if (state->mouseCurrent.x != x || state->mouseCurrent.y != y) {
-    // LOG_TRACE("Mouse position: %f %f", x, y);
+    // LOGC_TRACE(Input, "Mouse position: %f %f", x, y);
 
     state->mouseCurrent.x = x;
     state->mouseCurrent.y = y;
@@ -105,6 +305,8 @@ void input_process_mouse_move(f32 x, f32 y) {
 }
 
 void input_process_mouse_wheel(f32 xOffset, f32 yOffset) {
+  input_recorder_capture(InputRecordType::MouseWheel, 0, false, xOffset, yOffset);
+  push_sample(InputSampleType::MouseWheel, 0, false, xOffset, yOffset);
   EventContext context = {};
   context.f32[0]       = xOffset;
   context.f32[1]       = yOffset;
@@ -31,17 +31,57 @@ enum class Key : u16 {
 
 using MouseButton = u16;
 
+static constexpr u16 KEY_COUNT             = 512;
+static constexpr u16 MOUSE_BUTTON_COUNT    = 64;
+static constexpr u32 INPUT_SAMPLE_CAPACITY = 256; // Raw samples kept, a power of two
+
+enum class InputSampleType : u8 { Key, MouseButton, MouseMove, MouseWheel };
+
+// A raw input call as it was received from the platform
+struct InputSample {
+  f64             time; // platform_get_absolute_time() when the sample was received
+  InputSampleType type;
+  bool            pressed;
+  u16             code; // Key or mouse button
+  f32             x;    // Mouse position or wheel offset
+  f32             y;
+};
+
 void input_system_initialize(u64 *memorySize, void *pState);
 void input_system_shutdown();
 
 void input_update();
 
+// Raw samples received since the last `input_update`, oldest first. Writes up to `capacity` samples
+// and returns the number written.
+u32 input_get_frame_samples(InputSample *samples, u32 capacity);
+
+// Samples the cursor again right before it's consumed, e.g. before the view matrices are built,
+// without dispatching window events, those wait for the next poll. The latched position is kept
+// apart: the frame's input state, its edges and the recording stay as polled. When replaying, the
+// polled position is latched so the replay looks like the recorded run.
+void input_late_latch();
+// Mouse position as of the late latch, or the polled one if none happened since `input_update`
+void input_get_latched_mouse_position(f32 &x, f32 &y);
+// Time of the last late latch, or 0 if none happened since the last `input_update`
+f64 input_get_latch_time();
+// Time of the newest sample received since the last `input_update`, or 0 if there is none
+f64 input_get_latest_sample_time();
+
 // Keyboard input
 bool input_is_key_down(Key key);
 bool input_is_key_up(Key key);
 bool input_was_key_down(Key key);
 bool input_was_key_up(Key key);
 
+// Edges between the previous and the current frame
+bool input_is_key_pressed_this_frame(Key key);
+bool input_is_key_released_this_frame(Key key);
+// Bulk edge queries, write up to `capacity` keys and return the number written
+u32 input_get_keys_pressed_this_frame(Key *keys, u32 capacity);
+u32 input_get_keys_released_this_frame(Key *keys, u32 capacity);
+u32 input_get_keys_down(Key *keys, u32 capacity);
+
 void input_process_key(Key key, bool pressed);
 
 // Mouse input
@@ -50,6 +90,12 @@ bool input_is_mouse_button_up(MouseButton button);
 bool input_was_mouse_button_down(MouseButton button);
 bool input_was_mouse_button_up(MouseButton button);
 
+bool input_is_mouse_button_pressed_this_frame(MouseButton button);
+bool input_is_mouse_button_released_this_frame(MouseButton button);
+u32  input_get_mouse_buttons_pressed_this_frame(MouseButton *buttons, u32 capacity);
+u32  input_get_mouse_buttons_released_this_frame(MouseButton *buttons, u32 capacity);
+u32  input_get_mouse_buttons_down(MouseButton *buttons, u32 capacity);
+
 void input_get_mouse_position(f32 &x, f32 &y);
 void input_get_previous_mouse_position(f32 &x, f32 &y);
 
@@ -6,65 +6,584 @@
 #include "StringUtils.h"
 #include "platform.h"
 #include "platform/filesystem.h"
+#include <atomic>
 #include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
 #include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <strings.h>
+#include <thread>
+#include <unistd.h>
+
+static constexpr u64 LOG_MESSAGE_MAX_SIZE = 32 * KiB;
+static constexpr u64 LOG_SLOT_SIZE        = 2 * KiB; // Longer messages are truncated in async mode
+static constexpr u64 LOG_SLOT_COUNT       = 1024;    // Must be a power of two
+static constexpr u64 LOG_BATCH_SIZE       = 64 * KiB;
+static constexpr u32 LOG_DEFAULT_FLUSH_MS = 100;
+static constexpr u64 LOG_DEFAULT_FILE_SIZE = 16 * MiB;
+static constexpr u32 LOG_RATE_WINDOW_MS   = 1000;
+static constexpr u32 LOG_DEFAULT_RATE     = 20; // Per call site and window
+static constexpr u32 LOG_TRACKED_SITES    = 256;
+
+struct LogSlot {
+  std::atomic<u64> sequence;
+  u32              length;
+  u8               level;
+  bool             binary; // Holds a binary log record instead of a text line
+  u8               padding[2];
+  char             message[LOG_SLOT_SIZE - 16];
+};
+
+// Bounded MPSC queue. Producers claim a position with a CAS on `enqueuePos`. The slot's `sequence`
+// tells whether it's free for that position (== position) or holds a message (== position + 1).
+struct LogRing {
+  std::atomic<u64> enqueuePos;
+  u8               padding[56]; // Keep producers and the consumer off the same cache line
+  u64              dequeuePos;
+  LogSlot          slots[LOG_SLOT_COUNT];
+};
 
 struct LoggerSystemState {
-  FileHandle logFileHandle;
+  LogFile    logFile;
+  std::mutex fileMutex; // Writes come from the writer thread, or any thread in synchronous mode
+  bool       async;
+  bool       quiet;
+  u32        flushIntervalMs;
+
+  bool       binary;
+  LogFile    binaryFile;
+  u32        session; // Invalidates the format-string IDs cached in the call sites of earlier runs
+  u32        formatCount;
+  std::mutex registryMutex;
+  std::chrono::steady_clock::time_point startTime;
+
+  std::thread             writer;
+  std::atomic<bool>       running;
+  std::mutex              drainMutex; // Serializes consumers: the writer thread and `logging_flush`
+  std::mutex              wakeMutex;
+  std::condition_variable wake;
+
+  char    batch[LOG_BATCH_SIZE + 1];
+  u8      binaryBatch[LOG_BATCH_SIZE];
+  LogRing ring;
+};
+
+static LoggerSystemState *state   = nullptr;
+static u32                session = 0;
+
+// Kept outside of the state, call sites may log before the system is initialized
+static std::atomic<u32>      siteRateLimit = LOG_DEFAULT_RATE;
+static std::atomic<LogSite *> trackedSites[LOG_TRACKED_SITES];
+static std::atomic<u32>      trackedSiteCount;
+static const auto            epoch = std::chrono::steady_clock::now();
+
+static constexpr i32    crashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTRAP};
+static struct sigaction previousActions[sizeof(crashSignals) / sizeof(crashSignals[0])];
+
+static CString prefixes[6] = {"[Trace]", "[Debug]", "[Info]", "[Warn]", "[Error]", "[Fatal]"};
+
+static CString levelNames[6] = {"trace", "debug", "info", "warn", "error", "fatal"};
+
+static CString categoryNames[LOG_CATEGORY_COUNT] = {
+    "general",
+    "application",
+    "renderer",
+    "memory",
+    "input",
+    "platform",
 };
 
-static LoggerSystemState *state = nullptr;
+// Zero, i.e. Trace: everything that's compiled in is logged until told otherwise
+std::atomic<u8> logCategoryLevels[LOG_CATEGORY_COUNT];
 
 u64 get_current_time_in_ms() {
   auto now = std::chrono::system_clock::now();
   return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 }
 
-void append_to_log_file(CString message) {
+void append_to_log_file(CString message, u64 length) {
   if (state) { // Since the message already contains a '\n', just write the bytes directly
-    u64 length  = utils::string_length(message);
-    u64 written = 0;
-    if (!filesystem_write(&state->logFileHandle, length, message, &written)) {
-      platform_console_write_error("[Logging] Failed to write log to file");
+    std::lock_guard guard(state->fileMutex);
+    state->logFile.write(message, length);
+  }
+}
+
+static void write_binary(const void *data, u64 length) {
+  std::lock_guard guard(state->fileMutex);
+  state->binaryFile.write(data, length);
+}
+
+static void flush_files() {
+  std::lock_guard guard(state->fileMutex);
+  state->logFile.flush();
+  state->binaryFile.flush();
+}
+
+static void write_out(bool isError, CString text, u64 length) {
+  if (!state || !state->quiet) {
+    if (isError) {
+      platform_console_write_error(text);
+    } else {
+      platform_console_write(text);
+    }
+  }
+  append_to_log_file(text, length);
+}
+
+// Formats "<prefix> <message>\n" into `dst`, returns the length without the terminating zero
+static u32 format_line(char *dst, u64 size, LogLevel level, const char *message, va_list args) {
+  CString prefix       = prefixes[(u8) level];
+  u32     prefixLength = utils::string_length(prefix);
+  memcpy(dst, prefix, prefixLength);
+  dst[prefixLength] = ' ';
+  u32 length        = prefixLength + 1;
+  // Leave room for the '\n' and the terminating zero
+  length += utils::string_format_v(dst + length, size - length - 1, message, args);
+  dst[length++] = '\n';
+  dst[length]   = 0;
+  return length;
+}
+
+// Must be called with `drainMutex` held. Copies pending messages into the batch buffers and writes
+// them out whenever they're full or the output stream changes.
+static void drain() {
+  auto &ring              = state->ring;
+  u64   batchLength       = 0;
+  bool  batchIsError      = false;
+  u64   binaryBatchLength = 0;
+  for (;;) {
+    auto &slot = ring.slots[ring.dequeuePos & (LOG_SLOT_COUNT - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != ring.dequeuePos + 1) { break; }
+
+    if (slot.binary) {
+      if (binaryBatchLength + slot.length > LOG_BATCH_SIZE) {
+        write_binary(state->binaryBatch, binaryBatchLength);
+        binaryBatchLength = 0;
+      }
+      memcpy(state->binaryBatch + binaryBatchLength, slot.message, slot.length);
+      binaryBatchLength += slot.length;
+      slot.sequence.store(ring.dequeuePos + LOG_SLOT_COUNT, std::memory_order_release);
+      ring.dequeuePos++;
+      continue;
+    }
+
+    bool isError = slot.level >= (u8) LogLevel::Warn;
+    if (batchLength > 0 &&
+        (batchLength + slot.length > LOG_BATCH_SIZE || isError != batchIsError)) {
+      state->batch[batchLength] = 0;
+      write_out(batchIsError, state->batch, batchLength);
+      batchLength = 0;
+    }
+    memcpy(state->batch + batchLength, slot.message, slot.length);
+    batchLength += slot.length;
+    batchIsError = isError;
+
+    // Hand the slot back to the producers
+    slot.sequence.store(ring.dequeuePos + LOG_SLOT_COUNT, std::memory_order_release);
+    ring.dequeuePos++;
+  }
+  if (batchLength > 0) {
+    state->batch[batchLength] = 0;
+    write_out(batchIsError, state->batch, batchLength);
+  }
+  if (binaryBatchLength > 0) { write_binary(state->binaryBatch, binaryBatchLength); }
+  flush_files();
+}
+
+static LogSlot *claim_slot(u64 &position) {
+  auto &ring = state->ring;
+  position   = ring.enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    auto &slot     = ring.slots[position & (LOG_SLOT_COUNT - 1)];
+    u64   sequence = slot.sequence.load(std::memory_order_acquire);
+    i64   diff     = (i64) sequence - (i64) position;
+    if (diff == 0) {
+      auto &enqueuePos = ring.enqueuePos;
+      if (enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        return &slot;
+      }
+    } else if (diff < 0) { // Full, help the writer catch up
+      if (state->drainMutex.try_lock()) {
+        drain();
+        state->drainMutex.unlock();
+      } else {
+        std::this_thread::yield();
+      }
+      position = ring.enqueuePos.load(std::memory_order_relaxed);
+    } else { // Another producer took this position
+      position = ring.enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Queues a binary record, or writes it right away in synchronous mode
+static void submit_binary(const u8 *record, u32 length) {
+  if (!state->async) {
+    write_binary(record, length);
+    return;
+  }
+  u64  position = 0;
+  auto slot     = claim_slot(position);
+  memcpy(slot->message, record, length);
+  slot->length = length;
+  slot->binary = true;
+  slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+// Returns the format-string ID of the call site, writing its format record on first use
+static u32 register_site(LogSite &site) {
+  u64 key = site.binaryId.load(std::memory_order_acquire);
+  if ((key >> 32) == state->session) { return (u32) key; }
+
+  std::lock_guard guard(state->registryMutex);
+  key = site.binaryId.load(std::memory_order_relaxed);
+  if ((key >> 32) == state->session) { return (u32) key; }
+
+  u32 id           = ++state->formatCount;
+  u16 fileLength   = (u16) strnlen(site.file, 256);
+  u16 formatLength = (u16) strnlen(site.format, sizeof(LogSlot::message) - 512);
+
+  u8  record[LOG_SLOT_SIZE];
+  u8 *cursor = record;
+  binary_log_put(cursor, BinaryLogRecord::Format);
+  binary_log_put(cursor, id);
+  binary_log_put(cursor, (u8) site.level);
+  binary_log_put(cursor, site.line);
+  binary_log_put(cursor, fileLength);
+  memcpy(cursor, site.file, fileLength);
+  cursor += fileLength;
+  binary_log_put(cursor, formatLength);
+  memcpy(cursor, site.format, formatLength);
+  cursor += formatLength;
+  submit_binary(record, (u32) (cursor - record));
+
+  site.binaryId.store(((u64) state->session << 32) | id, std::memory_order_release);
+  return id;
+}
+
+// Every run starts a new file since the format records have to come first, the previous one is
+// archived. Not rotated while running for the same reason.
+static bool open_binary_log(u32 maxArchives) {
+  CString path = "pokemoon.log.bin";
+  if (filesystem_exists(path)) { log_file_rotate(path, maxArchives); }
+  if (!state->binaryFile.open({.path = path})) { return false; }
+  BinaryLogHeader header = {.version = BINARY_LOG_VERSION, .startTimeMs = get_current_time_in_ms()};
+  memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+  write_binary(&header, sizeof(header));
+  state->startTime = std::chrono::steady_clock::now();
+  state->session   = ++session;
+  return true;
+}
+
+static u32 get_elapsed_ms() {
+  auto elapsed = std::chrono::steady_clock::now() - epoch;
+  return (u32) std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+static void report_repeats(LogSite &site) {
+  u32 repeats = site.repeats.exchange(0, std::memory_order_relaxed);
+  if (repeats == 0) { return; }
+  log_output(site.level, "%s:%u: Last message repeated %u times", site.file, site.line, repeats);
+}
+
+// Starts a new window if the current one is over, or regardless with `force`, reporting what the
+// old one held back
+static void roll_window(LogSite &site, u32 now, bool force = false) {
+  u32 windowStart = site.windowStartMs.load(std::memory_order_relaxed);
+  if (!force && now - windowStart < LOG_RATE_WINDOW_MS) { return; }
+  if (!site.windowStartMs.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+    return; // Another thread rolled it
+  }
+  site.windowCount.store(0, std::memory_order_relaxed);
+  site.lastHash.store(0, std::memory_order_relaxed);
+  report_repeats(site);
+  u32 suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+  if (suppressed > 0) {
+    log_output(site.level,
+               "%s:%u: %u messages suppressed in the last %u ms",
+               site.file,
+               site.line,
+               suppressed,
+               now - windowStart);
+  }
+}
+
+static void track_site(LogSite &site) {
+  if (site.tracked.exchange(true, std::memory_order_relaxed)) { return; }
+  u32 index = trackedSiteCount.fetch_add(1, std::memory_order_relaxed);
+  if (index < LOG_TRACKED_SITES) { trackedSites[index].store(&site, std::memory_order_release); }
+}
+
+static std::atomic<u32> lastSweepMs;
+
+// Reports the counts of sites that went quiet after being limited. `force` ends all windows.
+static void sweep_tracked_sites(bool force) {
+  u32 now = get_elapsed_ms();
+  lastSweepMs.store(now, std::memory_order_relaxed);
+  u32 count = trackedSiteCount.load(std::memory_order_relaxed);
+  for (u32 i = 0; i < count && i < LOG_TRACKED_SITES; ++i) {
+    auto site = trackedSites[i].load(std::memory_order_acquire);
+    if (site) { roll_window(*site, now, force); }
+  }
+}
+
+bool log_site_admit(LogSite &site, u64 argumentsHash) {
+  if (site.level == LogLevel::Fatal) { return true; }
+  u32 now = get_elapsed_ms();
+  roll_window(site, now);
+
+  if (site.lastHash.exchange(argumentsHash, std::memory_order_relaxed) == argumentsHash) {
+    site.repeats.fetch_add(1, std::memory_order_relaxed);
+    track_site(site);
+    return false;
+  }
+  report_repeats(site);
+  if (site.windowCount.fetch_add(1, std::memory_order_relaxed) >=
+      siteRateLimit.load(std::memory_order_relaxed)) {
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    track_site(site);
+    return false;
+  }
+  return true;
+}
+
+static void writer_main() {
+  while (state->running.load(std::memory_order_acquire)) {
+    {
+      std::unique_lock lock(state->wakeMutex);
+      state->wake.wait_for(lock, std::chrono::milliseconds(state->flushIntervalMs));
+    }
+    sweep_tracked_sites(false);
+    std::lock_guard guard(state->drainMutex);
+    drain();
+  }
+}
+
+static void write_all(i32 fd, const void *data, u64 length) {
+  for (u64 offset = 0; fd >= 0 && offset < length;) {
+    auto written = ::write(fd, (const u8 *) data + offset, length - offset);
+    if (written < 0 && errno == EINTR) { continue; }
+    if (written <= 0) { return; }
+    offset += written;
+  }
+}
+
+// Best effort: get the messages still in the ring out before the process dies. Only lock-free
+// loads and write(2) here, anything else may deadlock or crash again inside a signal handler.
+// Whatever the writer thread was in the middle of writing may come out out of order.
+static void on_crash_signal(int signal) {
+  if (state && state->async) {
+    auto &ring     = state->ring;
+    i32   textFd   = state->logFile.append_fd();
+    i32   binaryFd = state->binary ? state->binaryFile.append_fd() : -1;
+    u64   position = ring.dequeuePos;
+    for (u64 i = 0; i < LOG_SLOT_COUNT; ++i, ++position) {
+      auto &slot = ring.slots[position & (LOG_SLOT_COUNT - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != position + 1) { break; }
+      if (slot.binary) {
+        write_all(binaryFd, slot.message, slot.length);
+        continue;
+      }
+      write_all(textFd, slot.message, slot.length);
+      if (!state->quiet) { write_all(STDERR_FILENO, slot.message, slot.length); }
+    }
+  }
+
+  // Hand the signal on to whoever had it before us, the default action if nobody did
+  for (u64 i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]); ++i) {
+    if (crashSignals[i] != signal) { continue; }
+    struct sigaction previous = previousActions[i];
+    if (!(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_IGN) {
+      previous.sa_handler = SIG_DFL;
     }
+    sigaction(signal, &previous, nullptr);
   }
+  raise(signal); // Delivered once this handler returns
 }
 
-void logging_system_initialize(u64 *memorySize, void *pState) {
+// Only in async mode, where messages can be stuck in the ring. Synchronous logging leaves any
+// handlers installed before, e.g. by sanitizers, alone.
+static void install_crash_handlers() {
+  struct sigaction action = {};
+  action.sa_handler       = on_crash_signal;
+  action.sa_flags         = SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+  for (u64 i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]); ++i) {
+    sigaction(crashSignals[i], &action, &previousActions[i]);
+  }
+}
+
+static void restore_crash_handlers() {
+  for (u64 i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]); ++i) {
+    sigaction(crashSignals[i], &previousActions[i], nullptr);
+  }
+}
+
+void logging_system_initialize(u64 *memorySize, void *pState, const LoggingConfig &config) {
   *memorySize = sizeof(LoggerSystemState);
   if (!pState) { return; }
-  state = (LoggerSystemState *) pState;
-  // Create new/wipe existing log file, then open it
-  ASSERT(filesystem_open("pokemoon.log", FILE_MODE_WRITE, false, &state->logFileHandle));
-}
+  state        = new (pState) LoggerSystemState();
+  state->quiet = config.quiet;
+  // Appends to the existing log, rotated files keep the history of earlier runs
+  LogFileConfig fileConfig = config.file;
+  if (!fileConfig.path) {
+    fileConfig = {.path = "pokemoon.log", .maxSize = LOG_DEFAULT_FILE_SIZE, .maxArchives = 5};
+  }
+  ASSERT(state->logFile.open(fileConfig));
+
+  siteRateLimit.store(config.siteRateLimit ? config.siteRateLimit : LOG_DEFAULT_RATE);
+  if (config.levels && !log_set_levels(config.levels)) {
+    LOG_WARN("Invalid log levels: '%s'", config.levels);
+  }
+  if (auto levels = getenv("POKEMOON_LOG_LEVELS"); levels && !log_set_levels(levels)) {
+    LOG_WARN("Invalid POKEMOON_LOG_LEVELS: '%s'", levels);
+  }
 
-void logging_system_shutdown() { state = nullptr; }
+  if (config.format == LogFormat::Binary) {
+    state->binary = open_binary_log(fileConfig.maxArchives);
+    if (!state->binary) { LOG_ERROR("Failed to open binary log, falling back to text"); }
+  }
 
-void log_output(LogLevel level, const char *message, ...) {
-  const char *prefixes[6] = {"[Trace]", "[Debug]", "[Info]", "[Warn]", "[Error]", "[Fatal]"};
+  if (!config.async) { return; }
 
-  const u64 size = 32 * KiB;
+  state->flushIntervalMs = config.flushIntervalMs ? config.flushIntervalMs : LOG_DEFAULT_FLUSH_MS;
+  for (u64 i = 0; i < LOG_SLOT_COUNT; ++i) {
+    state->ring.slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  state->running.store(true, std::memory_order_release);
+  state->writer = std::thread(writer_main);
+  state->async  = true;
+  install_crash_handlers();
+}
 
-  char buffer[size];
-  platform_zero_memory(buffer, sizeof(buffer));
+void logging_system_shutdown() {
+  sweep_tracked_sites(true);
+  if (state->async) {
+    restore_crash_handlers();
+    state->running.store(false, std::memory_order_release);
+    state->wake.notify_one();
+    state->writer.join();
+    drain();
+    state->async = false;
+  }
+  state->binaryFile.close();
+  state->logFile.close();
+  state->~LoggerSystemState();
+  state = nullptr;
+}
 
+void logging_poll() {
+  if (!state || state->async) { return; }
+  u32 last = lastSweepMs.load(std::memory_order_relaxed);
+  if (get_elapsed_ms() - last >= LOG_RATE_WINDOW_MS) { sweep_tracked_sites(false); }
+  // Nothing gets the buffered lines out if the process crashes, keep at most a frame's worth
+  flush_files();
+}
+
+void logging_flush() {
+  if (!state) { return; }
+  sweep_tracked_sites(false);
+  if (!state->async) {
+    flush_files();
+    return;
+  }
+  std::lock_guard guard(state->drainMutex);
+  drain();
+}
+
+void log_output(LogLevel level, const char *message, ...) {
   va_list args;
   va_start(args, message);
-  utils::string_format_v(buffer, message, args);
+
+  if (state && state->async) {
+    u64  position = 0;
+    auto slot     = claim_slot(position);
+    slot->level   = (u8) level;
+    slot->binary  = false;
+    slot->length  = format_line(slot->message, sizeof(slot->message), level, message, args);
+    slot->sequence.store(position + 1, std::memory_order_release); // Publish
+    va_end(args);
+
+    if (level == LogLevel::Fatal) {
+      logging_flush(); // Likely about to crash, don't leave it in the buffer
+    } else if (level >= LogLevel::Error || (position & (LOG_SLOT_COUNT / 4 - 1)) == 0) {
+      state->wake.notify_one();
+    }
+    return;
+  }
+
+  char out[LOG_MESSAGE_MAX_SIZE];
+  u32  length = format_line(out, sizeof(out), level, message, args);
   va_end(args);
 
-  char out[size];
-  platform_zero_memory(out, sizeof(out));
+  write_out(level >= LogLevel::Warn, out, length);
+  if (level >= LogLevel::Error) { flush_files(); }
+}
+
+void log_set_level(LogCategory category, LogLevel level) {
+  logCategoryLevels[(u8) category].store((u8) level, std::memory_order_relaxed);
+}
 
-  utils::string_format(out, "%s %s\n", prefixes[(u8) level], buffer);
+LogLevel log_get_level(LogCategory category) {
+  return (LogLevel) logCategoryLevels[(u8) category].load(std::memory_order_relaxed);
+}
 
-  if (level >= LogLevel::Warn) {
-    platform_console_write_error(out);
-  } else {
-    platform_console_write(out);
+template <u32 N>
+static i32 find_name(CString (&names)[N], CString token, u64 length) {
+  for (u32 i = 0; i < N; ++i) {
+    if (strlen(names[i]) == length && strncasecmp(names[i], token, length) == 0) { return (i32) i; }
   }
+  return -1;
+}
+
+bool log_set_levels(CString spec) {
+  bool valid = true;
+  while (*spec) {
+    u64     length = strcspn(spec, ",");
+    CString equals = (CString) memchr(spec, '=', length);
+    if (equals) {
+      i32 category = find_name(categoryNames, spec, equals - spec);
+      i32 level    = find_name(levelNames, equals + 1, spec + length - equals - 1);
+      if (category >= 0 && level >= 0) {
+        log_set_level((LogCategory) category, (LogLevel) level);
+      } else {
+        valid = false;
+      }
+    } else if (i32 level = find_name(levelNames, spec, length); level >= 0) {
+      for (u8 i = 0; i < LOG_CATEGORY_COUNT; ++i) {
+        log_set_level((LogCategory) i, (LogLevel) level);
+      }
+    } else if (length > 0) {
+      valid = false;
+    }
+    spec += length;
+    if (*spec == ',') { ++spec; }
+  }
+  return valid;
+}
+
+bool log_is_binary() { return state && state->binary; }
+
+void log_output_binary(LogSite &site, const u8 *payload, u32 size) {
+  if (!log_is_binary()) { return; }
+  u32 id          = register_site(site);
+  u64 timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - state->startTime)
+                        .count();
 
-  append_to_log_file(out);
+  u8  record[BINARY_LOG_ENTRY_HEADER + BINARY_LOG_MAX_PAYLOAD];
+  u8 *cursor = record;
+  binary_log_put(cursor, BinaryLogRecord::Entry);
+  binary_log_put(cursor, id);
+  binary_log_put(cursor, timestampNs);
+  binary_log_put(cursor, (u16) size);
+  if (size) { memcpy(cursor, payload, size); }
+  submit_binary(record, BINARY_LOG_ENTRY_HEADER + size);
 }
 
 void report_assertion_failure(CString expression, CString file, u32 line) {
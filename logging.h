@@ -5,25 +5,168 @@
 #ifndef POKEMOON_LOGGING_H
 #define POKEMOON_LOGGING_H
 
+#include "core/BinaryLog.h"
+#include "core/LogFile.h"
 #include "defines.h"
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 
 enum class LogLevel { Trace = 0, Debug, Info, Warn, Error, Fatal };
 
-void logging_system_initialize(u64 *memorySize, void *pState);
-void logging_system_shutdown();
+enum class LogCategory : u8 { General = 0, Application, Renderer, Memory, Input, Platform };
 
-void log_output(LogLevel level, const char *message, ...);
+static constexpr u8 LOG_CATEGORY_COUNT = 6;
 
+// Calls below this level are compiled out, arguments included. Override with e.g.
+// -DLOG_MIN_LEVEL=3 to keep only warnings and above.
+#ifndef LOG_MIN_LEVEL
 #ifdef DEBUG
-#define LOG_TRACE(message, ...) log_output(LogLevel::Trace, message, ##__VA_ARGS__);
-#define LOG_DEBUG(message, ...) log_output(LogLevel::Debug, message, ##__VA_ARGS__);
+#define LOG_MIN_LEVEL 0
 #else
-#define LOG_TRACE(message, ...)
-#define LOG_DEBUG(message, ...)
+#define LOG_MIN_LEVEL 2
 #endif
-#define LOG_INFO(message, ...)  log_output(LogLevel::Info, message, ##__VA_ARGS__);
-#define LOG_WARN(message, ...)  log_output(LogLevel::Warn, message, ##__VA_ARGS__);
-#define LOG_ERROR(message, ...) log_output(LogLevel::Error, message, ##__VA_ARGS__);
-#define LOG_FATAL(message, ...) log_output(LogLevel::Fatal, message, ##__VA_ARGS__);
+#endif
+
+enum class LogFormat : u8 {
+  Text = 0,
+  // Call sites store a format-string ID plus the raw argument bytes into pokemoon.log.bin, see
+  // tools/LogDecoder.cpp to turn it back into text. Warnings and above are also written as text.
+  Binary,
+};
+
+// Static per call site, created by the LOG_* macros
+struct LogSite {
+  CString          format;
+  CString          file;
+  u32              line;
+  LogLevel         level;
+  std::atomic<u64> binaryId; // Session in the high, format-string ID in the low 32 bits
+
+  // Rate limiting and deduplication, counted per one second window
+  std::atomic<u32>  windowStartMs;
+  std::atomic<u32>  windowCount;
+  std::atomic<u64>  lastHash; // Hash of the arguments of the last message written
+  std::atomic<u32>  repeats;
+  std::atomic<u32>  suppressed;
+  std::atomic<bool> tracked; // Pending counts get reported by the writer thread and at shutdown
+};
+
+struct LoggingConfig {
+  // Format into a ring buffer and let a background thread do the console and file writes
+  bool async;
+  // How often the writer thread wakes up to flush the ring buffer, in milliseconds
+  u32 flushIntervalMs;
+  // Only write the log file, nothing goes to the console
+  bool quiet;
+
+  LogFormat format;
+  // Initial per-category levels, see `log_set_levels`. POKEMOON_LOG_LEVELS in the environment is
+  // applied on top.
+  CString levels;
+  // Messages a single call site may write per second, the rest are counted and summarized.
+  // Zero uses the default.
+  u32 siteRateLimit;
+
+  // Text log file. Defaults to pokemoon.log, rotated at 16 MiB with 5 archives, if `path` is null.
+  LogFileConfig file;
+};
+
+void logging_system_initialize(u64 *memorySize, void *pState, const LoggingConfig &config = {});
+void logging_system_shutdown();
+
+// Writes out all pending messages on the calling thread, summaries of rate-limited call sites that
+// went quiet included
+void logging_flush();
+
+// Summarizes rate-limited call sites that went quiet, at most every rate window, and writes out
+// the buffered log files. Call once per frame, the async writer thread does both on its own.
+void logging_poll();
+
+void log_output(LogLevel level, const char *message, ...);
+
+// Minimum level per category, read by every call site before its arguments are evaluated
+extern std::atomic<u8> logCategoryLevels[LOG_CATEGORY_COUNT];
+
+inline bool log_is_enabled(LogCategory category, LogLevel level) {
+  return (u8) level >= logCategoryLevels[(u8) category].load(std::memory_order_relaxed);
+}
+
+void     log_set_level(LogCategory category, LogLevel level);
+LogLevel log_get_level(LogCategory category);
+// Parses a comma separated list like "warn,renderer=trace,memory=error". A bare level applies to
+// all categories. Returns false if any entry was invalid, the valid ones are applied anyway.
+bool log_set_levels(CString spec);
+
+// Returns false if the message is a repeat of the site's previous one or over its rate limit
+bool log_site_admit(LogSite &site, u64 argumentsHash);
+
+bool log_is_binary();
+void log_output_binary(LogSite &site, const u8 *payload, u32 size);
+
+template <typename Arg>
+inline u64 log_hash_arg(u64 hash, const Arg &arg) {
+  constexpr u64 prime = 0x100000001b3;
+  using T             = std::decay_t<Arg>;
+  if constexpr (std::is_same_v<T, char *> || std::is_same_v<T, const char *>) {
+    u32 length = log_string_arg_length(arg);
+    for (u32 i = 0; i < length; ++i) {
+      hash = (hash ^ (u8) arg[i]) * prime;
+    }
+    return hash * prime;
+  } else {
+    u64 bits = 0;
+    memcpy(&bits, &arg, sizeof(T) < sizeof(bits) ? sizeof(T) : sizeof(bits));
+    return (hash ^ bits) * prime;
+  }
+}
+
+template <typename... Args>
+void log_site_output(LogSite &site, const Args &...args) {
+  u64 hash = 0xcbf29ce484222325;
+  ((hash = log_hash_arg(hash, args)), ...);
+  if (!log_site_admit(site, hash | 1)) { return; }
+  if (log_is_binary()) {
+    if constexpr (sizeof...(Args) == 0) {
+      log_output_binary(site, nullptr, 0);
+    } else {
+      u8 payload[BINARY_LOG_MAX_PAYLOAD];
+      log_output_binary(site, payload, binary_log_encode(payload, args...));
+    }
+    if (site.level < LogLevel::Warn) { return; }
+  }
+  log_output(site.level, site.format, args...);
+}
+
+// `message` has to be a string literal, it's captured once per call site
+#define LOG_AT(category, level, message, ...)                                                      \
+  do {                                                                                             \
+    if constexpr ((u8) (level) >= LOG_MIN_LEVEL) {                                                 \
+      if (log_is_enabled(category, level)) {                                                       \
+        static LogSite logSite = {"" message, __FILE_NAME__, __LINE__, level, {0}};                \
+        log_site_output(logSite, ##__VA_ARGS__);                                                   \
+      }                                                                                            \
+    }                                                                                              \
+  } while (0)
+
+#define LOGC_TRACE(category, message, ...)                                                         \
+  LOG_AT(LogCategory::category, LogLevel::Trace, message, ##__VA_ARGS__);
+#define LOGC_DEBUG(category, message, ...)                                                         \
+  LOG_AT(LogCategory::category, LogLevel::Debug, message, ##__VA_ARGS__);
+#define LOGC_INFO(category, message, ...)                                                          \
+  LOG_AT(LogCategory::category, LogLevel::Info, message, ##__VA_ARGS__);
+#define LOGC_WARN(category, message, ...)                                                          \
+  LOG_AT(LogCategory::category, LogLevel::Warn, message, ##__VA_ARGS__);
+#define LOGC_ERROR(category, message, ...)                                                         \
+  LOG_AT(LogCategory::category, LogLevel::Error, message, ##__VA_ARGS__);
+#define LOGC_FATAL(category, message, ...)                                                         \
+  LOG_AT(LogCategory::category, LogLevel::Fatal, message, ##__VA_ARGS__);
+
+#define LOG_TRACE(message, ...) LOGC_TRACE(General, message, ##__VA_ARGS__)
+#define LOG_DEBUG(message, ...) LOGC_DEBUG(General, message, ##__VA_ARGS__)
+#define LOG_INFO(message, ...)  LOGC_INFO(General, message, ##__VA_ARGS__)
+#define LOG_WARN(message, ...)  LOGC_WARN(General, message, ##__VA_ARGS__)
+#define LOG_ERROR(message, ...) LOGC_ERROR(General, message, ##__VA_ARGS__)
+#define LOG_FATAL(message, ...) LOGC_FATAL(General, message, ##__VA_ARGS__)
 
 #endif // POKEMOON_LOGGING_H
@@ -1,11 +1,69 @@
 #include "application.h"
+#include <cstdlib>
+#include <cstring>
 
-int main() {
+int main(int argc, char **argv) {
   ApplicationConfig config = {
       .appName = "Pokemoon",
       .width   = 240,
       .height  = 240,
+
+      .targetFrameRate     = 60,
+      .backgroundFrameRate = 10,
+      .tickRate            = 60,
+      .maxTicksPerFrame    = 5,
+
+      .logging = {.async = true, .flushIntervalMs = 100},
+
+      .inputBindingsPath = "assets/config/input.cfg",
+
+      .assetArchivePath = "assets.pak",
+      .assetDirectory   = "assets",
   };
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      config.inputRecorderMode  = InputRecorderMode::Record;
+      config.inputRecordingPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      config.inputRecorderMode  = InputRecorderMode::Replay;
+      config.inputRecordingPath = argv[++i];
+    } else if (strcmp(argv[i], "--late-latch") == 0) {
+      config.lateLatchInput = true;
+    } else if (strcmp(argv[i], "--binary-log") == 0) {
+      config.logging.format = LogFormat::Binary;
+    } else if (strcmp(argv[i], "--log-levels") == 0 && i + 1 < argc) {
+      config.logging.levels = argv[++i];
+    } else if (strcmp(argv[i], "--hot-reload") == 0) {
+      config.hotReload = true;
+    } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      ++i; // A rate, e.g. 60, 120 or 144, or "unlimited"
+      config.targetFrameRate = strcmp(argv[i], "unlimited") == 0 ? 0 : (u32) atoi(argv[i]);
+    } else if (strcmp(argv[i], "--background-fps") == 0 && i + 1 < argc) {
+      config.backgroundFrameRate = (u32) atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+      config.tickRate = (u32) atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+      config.maxTicksPerFrame = (u32) atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--cycle-timer") == 0) {
+      config.cycleCounterTimer = true;
+    } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+      config.profilePath = argv[++i];
+    } else if (strcmp(argv[i], "--frame-stats") == 0 && i + 1 < argc) {
+      config.frameStatsPath = argv[++i];
+    } else if (strcmp(argv[i], "--perf-counters") == 0) {
+      config.perfCounters = true;
+    } else if (strcmp(argv[i], "--perf-counters-zones") == 0) {
+      config.perfCountersZones = true;
+    } else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+      config.benchmarkFrames = (u32) atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--benchmark-report") == 0 && i + 1 < argc) {
+      config.benchmarkReportPath = argv[++i];
+    } else if (strcmp(argv[i], "--benchmark-budget") == 0 && i + 1 < argc) {
+      config.benchmarkBudgetMs = (f32) atof(argv[++i]);
+    }
+  }
+
   application_create(config);
-  application_run();
+  return application_run();
 }
@@ -11,6 +11,7 @@
 struct MemorySystemState {
   struct {
     u64 allocated;
+    u64 peak;
     u64 allocations[MEMORY_TAG_COUNT];
   } stats{};
   u64 allocCount = 0;
@@ -33,6 +34,9 @@ static CString memoryTags[MEMORY_TAG_COUNT] = {
     "Fence",
     "Image",
     "ImageView",
+    "Input",
+    "Asset",
+    "Profiler",
 };
 
 void memory_system_initialize() {}
@@ -40,8 +44,9 @@ void memory_system_initialize() {}
 void memory_system_shutdown() {}
 
 void *memory_allocate(u64 size, MemoryTag tag) {
-  if (tag == MemoryTag::Unknown) { LOG_WARN("Allocating unknown memory"); }
+  if (tag == MemoryTag::Unknown) { LOGC_WARN(Memory, "Allocating unknown memory"); }
   state.stats.allocated += size;
+  if (state.stats.allocated > state.stats.peak) { state.stats.peak = state.stats.allocated; }
   state.stats.allocations[(u16) tag] += size;
   state.allocCount++;
   void *block = platform_allocate(size);
@@ -52,7 +57,7 @@ void *memory_allocate(u64 size, MemoryTag tag) {
 void *memory_allocate(u64 stride, u32 n, MemoryTag tag) { return memory_allocate(stride * n, tag); }
 
 void memory_free(void *block, u64 size, MemoryTag tag) {
-  if (tag == MemoryTag::Unknown) { LOG_WARN("Freeing unknown memory"); }
+  if (tag == MemoryTag::Unknown) { LOGC_WARN(Memory, "Freeing unknown memory"); }
   state.stats.allocated -= size;
   state.stats.allocations[(u16) tag] -= size;
   platform_free(block);
@@ -98,3 +103,7 @@ char *memory_get_usage() {
 }
 
 u64 memory_get_alloc_count() { return state.allocCount; }
+
+u64 memory_get_allocated() { return state.stats.allocated; }
+
+u64 memory_get_peak() { return state.stats.peak; }
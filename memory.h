@@ -7,7 +7,7 @@
 
 #include "defines.h"
 
-static constexpr u16 MEMORY_TAG_COUNT = 14;
+static constexpr u16 MEMORY_TAG_COUNT = 17;
 enum class MemoryTag : u16 {
   Unknown = 0,
   LINEAR_ALLOCATOR,
@@ -23,6 +23,9 @@ enum class MemoryTag : u16 {
   Fence,
   Image,
   ImageView,
+  Input,
+  Asset,
+  Profiler,
   // When adding more variables, make sure to update MEMORY_TAG_COUNT
 };
 
@@ -39,6 +42,8 @@ void *memory_set(void *dst, i32 value, u64 size);
 
 char *memory_get_usage();
 u64   memory_get_alloc_count();
+u64   memory_get_allocated();
+u64   memory_get_peak(); // Highest memory_get_allocated() so far
 
 #define MEMORY_ALLOCATE(type, n, tag) (typeof(type) *) memory_allocate(sizeof(type) * (n), tag);
 #define MEMORY_FREE(block, type, n, tag)                                                           \
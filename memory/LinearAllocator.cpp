@@ -21,12 +21,13 @@ LinearAllocator::~LinearAllocator() {
 
 void *LinearAllocator::alloc(u64 size) {
   if (!_memory) {
-    LOG_ERROR("[LinearAllocator] Not initialized.");
+    LOGC_ERROR(Memory, "[LinearAllocator] Not initialized.");
     return nullptr;
   }
   if (_allocated + size > _size) {
     auto remaining = _size - _allocated;
-    LOG_ERROR("[LinearAllocator] Try to alloc %llu B, yet %llu B remaining.", size, remaining);
+    LOGC_ERROR(
+        Memory, "[LinearAllocator] Try to alloc %llu B, yet %llu B remaining.", size, remaining);
     return nullptr;
   }
 
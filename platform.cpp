@@ -4,35 +4,39 @@
 
 #include "platform.h"
 #include "container/darray.h"
+#include "core/InputRecorder.h"
+#include "core/Profiler.h"
 #include "event.h"
 #include "input.h"
 #include "logging.h"
 #include "memory.h"
 #include "renderer/types.h"
 #include <GLFW/glfw3.h>
-#include <chrono>
 #include <cstdio>
-#include <cstdlib>
 #include <cstring>
-#include <thread>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_metal.h>
 
 struct PlatformSystemState {
   GLFWwindow *window = nullptr;
+  bool        headless; // No window, surfaces come from VK_EXT_headless_surface
+  u32         width;
+  u32         height;
 };
 
 static PlatformSystemState *state = nullptr;
 
 static void glfw_error_callback(int error, const char *description) {
-  LOG_ERROR("GLFW error: %s", description);
+  LOGC_ERROR(Platform, "GLFW error: %s", description);
 }
 
 static void glfw_close_callback(GLFWwindow *window) {
+  input_recorder_capture_event(EventCode::ApplicationQuit, {});
   event_fire(EventCode::ApplicationQuit, nullptr, {});
 }
 
 static void glfw_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+  if (input_recorder_is_replaying()) { return; } // Input comes from the recording instead
   bool pressed = (action == GLFW_PRESS) || (action == GLFW_REPEAT);
   input_process_key((Key) key, pressed);
 }
@@ -41,28 +45,51 @@ static void glfw_framebuffer_size_callback(GLFWwindow *window, int width, int he
   EventContext context{};
   context.u32[0] = width;
   context.u32[1] = height;
+  input_recorder_capture_event(EventCode::WindowResized, context);
   event_fire(EventCode::WindowResized, nullptr, context);
 }
 
 static void glfw_mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+  if (input_recorder_is_replaying()) { return; }
   bool pressed = (action == GLFW_PRESS) || (action == GLFW_REPEAT);
   input_process_mouse_button((MouseButton) button, pressed);
 }
 
 static void glfw_cursor_position_callback(GLFWwindow *window, f64 xPos, f64 yPos) {
+  if (input_recorder_is_replaying()) { return; }
   input_process_mouse_move((f32) xPos, (f32) yPos);
 }
 
 static void glfw_scroll_callback(GLFWwindow *window, f64 xOffset, f64 yOffset) {
+  if (input_recorder_is_replaying()) { return; }
   input_process_mouse_wheel((f32) xOffset, (f32) yOffset);
 }
 
 static void glfw_refresh_callback(GLFWwindow *window) {}
 
-void platform_system_startup(u64 *memorySize, void *pState, CString name, u32 width, u32 height) {
+// Not recorded, focus only changes how often frames are made
+static void glfw_focus_callback(GLFWwindow *window, int focused) {
+  EventContext context{};
+  context.u8[0] = focused == GLFW_TRUE;
+  event_fire(EventCode::WindowFocused, nullptr, context);
+}
+
+void platform_system_startup(u64    *memorySize,
+                             void   *pState,
+                             CString name,
+                             u32     width,
+                             u32     height,
+                             bool    headless) {
   *memorySize = sizeof(PlatformSystemState);
   if (!pState) { return; }
-  state = (PlatformSystemState *) pState;
+  state           = (PlatformSystemState *) pState;
+  state->headless = headless;
+  state->width    = width;
+  state->height   = height;
+  if (headless) {
+    LOGC_INFO(Platform, "Headless, rendering %ux%u without a window", width, height);
+    return;
+  }
 
   glfwSetErrorCallback(glfw_error_callback);
   ASSERT(glfwInit() == GLFW_TRUE);
@@ -76,46 +103,77 @@ void platform_system_startup(u64 *memorySize, void *pState, CString name, u32 wi
   glfwSetCursorPosCallback(window, glfw_cursor_position_callback);
   glfwSetScrollCallback(window, glfw_scroll_callback);
   glfwSetWindowRefreshCallback(window, glfw_refresh_callback);
+  glfwSetWindowFocusCallback(window, glfw_focus_callback);
 
   state->window = window;
 }
 
 void platform_system_shutdown() {
-  glfwDestroyWindow(state->window);
-  glfwTerminate();
-  glfwSetErrorCallback(nullptr);
+  if (!state->headless) {
+    glfwDestroyWindow(state->window);
+    glfwTerminate();
+    glfwSetErrorCallback(nullptr);
+  }
   state = nullptr;
 }
 
-void platform_poll_events() { glfwPollEvents(); }
-
-void *platform_allocate(u64 size, bool aligned) { return malloc(size); }
-
-void platform_free(void *block, bool aligned) { free(block); }
-
-void *platform_zero_memory(void *block, u64 size) { return platform_set_memory(block, 0, size); }
-
-void *platform_copy_memory(void *dst, const void *src, u64 size) { return memcpy(dst, src, size); }
-
-void *platform_set_memory(void *dst, i32 value, u64 size) { return memset(dst, value, size); }
-
-void platform_console_write(CString message) { fprintf(stdout, "%s", message); }
-
-void platform_console_write_error(CString message) { fprintf(stderr, "%s", message); }
-
-f64 platform_get_absolute_time() { return glfwGetTime(); }
+void platform_poll_events() {
+  PROFILE_SCOPE("poll_events");
+  if (!state->headless) { glfwPollEvents(); }
+}
 
-void platform_sleep(u64 ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void platform_wait_events(u64 timeoutNs) {
+  PROFILE_SCOPE("wait_events");
+  if (state->headless) {
+    platform_sleep(timeoutNs / 1000000);
+    return;
+  }
+  glfwWaitEventsTimeout((f64) timeoutNs * 1e-9);
+}
 
 void platform_get_framebuffer_size(u32 &width, u32 &height) {
+  if (state->headless) {
+    width  = state->width;
+    height = state->height;
+    return;
+  }
   glfwGetFramebufferSize(state->window, (int *) (&width), (int *) (&height));
 }
 
+void platform_get_window_size(u32 &width, u32 &height) {
+  width  = 0;
+  height = 0;
+  if (state->headless) { return; }
+  glfwGetWindowSize(state->window, (int *) (&width), (int *) (&height));
+}
+
+bool platform_sample_cursor(f32 &x, f32 &y) {
+  if (state->headless) { return false; }
+  f64 xPos = 0, yPos = 0;
+  glfwGetCursorPos(state->window, &xPos, &yPos);
+  x = (f32) xPos;
+  y = (f32) yPos;
+  return true;
+}
+
 void platform_get_required_extension(CString *&extensions) {
+  if (state->headless) {
+    DARRAY_PUSH(extensions, &VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+    return;
+  }
   DARRAY_PUSH(extensions, &VK_EXT_METAL_SURFACE_EXTENSION_NAME);
 }
 
 void platform_create_surface(Context *context) {
+  if (state->headless) {
+    auto create = (PFN_vkCreateHeadlessSurfaceEXT) vkGetInstanceProcAddr(
+        context->instance, "vkCreateHeadlessSurfaceEXT");
+    ASSERT(create);
+    VkHeadlessSurfaceCreateInfoEXT createInfo = {
+        VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT};
+    VK_CHECK(create(context->instance, &createInfo, context->allocator, &context->surface));
+    return;
+  }
   auto error = glfwCreateWindowSurface(
       context->instance, state->window, context->allocator, &context->surface);
   VK_CHECK(error);
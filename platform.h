@@ -11,12 +11,23 @@ struct PlatformState {
   void *internalState;
 };
 
-void platform_system_startup(u64 *memorySize, void *pState, CString name, u32 width, u32 height);
+// A headless platform has no window or input, frames are presented to a
+// VK_EXT_headless_surface of `width` x `height`
+void platform_system_startup(u64    *memorySize,
+                             void   *pState,
+                             CString name,
+                             u32     width,
+                             u32     height,
+                             bool    headless = false);
 
 void platform_system_shutdown();
 
 void platform_poll_events();
 
+// Like platform_poll_events(), but blocks until an event arrives or `timeoutNs` passes, e.g. while
+// minimized or in the background. Headless, just sleeps.
+void platform_wait_events(u64 timeoutNs);
+
 void *platform_allocate(u64 size, bool aligned = false);
 
 void platform_free(void *block, bool aligned = false);
@@ -35,6 +46,15 @@ f64 platform_get_absolute_time();
 
 void platform_sleep(u64 ms);
 
+u64 platform_get_peak_resident_memory(); // In bytes, of the whole process
+
 void platform_get_framebuffer_size(u32 &width, u32 &height);
 
+// In screen coordinates, like the cursor. 0 x 0 when headless.
+void platform_get_window_size(u32 &width, u32 &height);
+
+// Reads the cursor position from the window system as it is now, without dispatching any pending
+// events. Returns false if there is no window.
+bool platform_sample_cursor(f32 &x, f32 &y);
+
 #endif // POKEMOON_PLATFORM_H
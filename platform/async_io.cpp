@@ -0,0 +1,338 @@
+//
+// Created by Hongjian Zhu on 2022/10/28.
+//
+
+#include "platform/async_io.h"
+#include "core/ThreadPool.h"
+#include "event.h"
+#include "logging.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef PLATFORM_LINUX
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+struct AsyncRead {
+  u32              id; // 0 while the slot is free
+  i32              fd;
+  u64              offset;
+  u64              size;
+  u64              done; // Bytes read so far
+  u8              *dst;
+  i32              error;
+  PFN_on_file_read callback;
+  void            *userData;
+  iovec            iov;
+};
+
+#ifdef PLATFORM_LINUX
+// Submission and completion rings shared with the kernel
+struct Uring {
+  i32           fd;
+  void         *sqRing;
+  u64           sqRingSize;
+  void         *cqRing; // Same as `sqRing` with IORING_FEAT_SINGLE_MMAP
+  u64           cqRingSize;
+  io_uring_sqe *sqes;
+  u64           sqesSize;
+  u32          *sqTail;
+  u32          *sqMask;
+  u32          *sqArray;
+  u32          *cqHead;
+  u32          *cqTail;
+  u32          *cqMask;
+  io_uring_cqe *cqes;
+  u32           unsubmitted; // Queued in the ring, not yet taken by the kernel
+};
+#endif
+
+struct AsyncIoState {
+  AsyncRead reads[ASYNC_IO_MAX_READS];
+  u32       freeSlots[ASYNC_IO_MAX_READS];
+  u32       freeCount;
+  u32       nextId;
+  u32       inFlight;
+
+  bool useUring;
+#ifdef PLATFORM_LINUX
+  Uring uring;
+#endif
+  ThreadPool pool;
+
+  // Finished reads waiting for `async_io_poll`, filled by the pool's workers
+  std::mutex completedMutex;
+  u32        completed[ASYNC_IO_MAX_READS];
+  u32        completedCount;
+  u32        dispatching[ASYNC_IO_MAX_READS];
+};
+
+static AsyncIoState *state = nullptr;
+
+static void push_completed(u32 index) {
+  std::lock_guard guard(state->completedMutex);
+  state->completed[state->completedCount++] = index;
+}
+
+#ifdef PLATFORM_LINUX
+static i32 sys_io_uring_setup(u32 entries, io_uring_params *params) {
+  return (i32) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static i32 sys_io_uring_enter(i32 fd, u32 toSubmit, u32 minComplete, u32 flags) {
+  return (i32) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static bool uring_create(Uring &uring, u32 entries) {
+  io_uring_params params{};
+  uring.fd = sys_io_uring_setup(entries, &params);
+  if (uring.fd < 0) { return false; }
+
+  uring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+  uring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMap   = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (singleMap) {
+    uring.sqRingSize = uring.cqRingSize =
+        uring.sqRingSize > uring.cqRingSize ? uring.sqRingSize : uring.cqRingSize;
+  }
+  uring.sqRing = mmap(nullptr,
+                      uring.sqRingSize,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      uring.fd,
+                      IORING_OFF_SQ_RING);
+  if (uring.sqRing == MAP_FAILED) {
+    close(uring.fd);
+    return false;
+  }
+  uring.cqRing = singleMap ? uring.sqRing
+                           : mmap(nullptr,
+                                  uring.cqRingSize,
+                                  PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE,
+                                  uring.fd,
+                                  IORING_OFF_CQ_RING);
+  uring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  uring.sqes     = (io_uring_sqe *) mmap(nullptr,
+                                     uring.sqesSize,
+                                     PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE,
+                                     uring.fd,
+                                     IORING_OFF_SQES);
+  if (uring.cqRing == MAP_FAILED || uring.sqes == MAP_FAILED) {
+    munmap(uring.sqRing, uring.sqRingSize);
+    if (!singleMap && uring.cqRing != MAP_FAILED) { munmap(uring.cqRing, uring.cqRingSize); }
+    if (uring.sqes != MAP_FAILED) { munmap(uring.sqes, uring.sqesSize); }
+    close(uring.fd);
+    return false;
+  }
+
+  auto sq           = (u8 *) uring.sqRing;
+  auto cq           = (u8 *) uring.cqRing;
+  uring.sqTail      = (u32 *) (sq + params.sq_off.tail);
+  uring.sqMask      = (u32 *) (sq + params.sq_off.ring_mask);
+  uring.sqArray     = (u32 *) (sq + params.sq_off.array);
+  uring.cqHead      = (u32 *) (cq + params.cq_off.head);
+  uring.cqTail      = (u32 *) (cq + params.cq_off.tail);
+  uring.cqMask      = (u32 *) (cq + params.cq_off.ring_mask);
+  uring.cqes        = (io_uring_cqe *) (cq + params.cq_off.cqes);
+  uring.unsubmitted = 0;
+  return true;
+}
+
+static void uring_destroy(Uring &uring) {
+  munmap(uring.sqes, uring.sqesSize);
+  if (uring.cqRing != uring.sqRing) { munmap(uring.cqRing, uring.cqRingSize); }
+  munmap(uring.sqRing, uring.sqRingSize);
+  close(uring.fd);
+}
+
+static void uring_flush(Uring &uring) {
+  if (uring.unsubmitted == 0) { return; }
+  i32 submitted = sys_io_uring_enter(uring.fd, uring.unsubmitted, 0, 0);
+  if (submitted > 0) { uring.unsubmitted -= submitted; }
+}
+
+// Queues the remaining part of the read, at most one per request is in the ring at a time so the
+// ring can't overflow
+static void uring_queue(Uring &uring, u32 index) {
+  auto &read = state->reads[index];
+  read.iov   = {read.dst + read.done, read.size - read.done};
+
+  u32   tail = *uring.sqTail;
+  u32   slot = tail & *uring.sqMask;
+  auto &sqe  = uring.sqes[slot];
+  memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode          = IORING_OP_READV;
+  sqe.fd              = read.fd;
+  sqe.off             = read.offset + read.done;
+  sqe.addr            = (u64) (uintptr_t) &read.iov;
+  sqe.len             = 1;
+  sqe.user_data       = index;
+  uring.sqArray[slot] = slot;
+  __atomic_store_n(uring.sqTail, tail + 1, __ATOMIC_RELEASE);
+  uring.unsubmitted++;
+}
+
+static void uring_reap(Uring &uring) {
+  u32 head = *uring.cqHead;
+  u32 tail = __atomic_load_n(uring.cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const auto &cqe   = uring.cqes[head & *uring.cqMask];
+    u32         index = (u32) cqe.user_data;
+    auto       &read  = state->reads[index];
+    if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN) {
+      read.error = -cqe.res;
+    } else if (cqe.res > 0) {
+      read.done += cqe.res;
+    }
+    bool finished = read.error != 0 || cqe.res == 0 || read.done == read.size;
+    if (finished) {
+      push_completed(index);
+    } else {
+      uring_queue(uring, index);
+    }
+  }
+  __atomic_store_n(uring.cqHead, head, __ATOMIC_RELEASE);
+  uring_flush(uring);
+}
+#endif
+
+static void read_job(void *data) {
+  auto &read = *(AsyncRead *) data;
+  while (read.done < read.size) {
+    u64  remaining = read.size - read.done;
+    auto result    = pread(read.fd, read.dst + read.done, remaining, read.offset + read.done);
+    if (result < 0 && errno == EINTR) { continue; }
+    if (result < 0) { read.error = errno; }
+    if (result <= 0) { break; }
+    read.done += result;
+  }
+  push_completed((u32) (&read - state->reads));
+}
+
+void async_io_initialize(u64 *memorySize, void *pState, const AsyncIoConfig &config) {
+  *memorySize = sizeof(AsyncIoState);
+  if (!pState) { return; }
+  state = new (pState) AsyncIoState();
+  for (u32 i = 0; i < ASYNC_IO_MAX_READS; ++i) {
+    state->freeSlots[i] = ASYNC_IO_MAX_READS - 1 - i;
+  }
+  state->freeCount = ASYNC_IO_MAX_READS;
+
+#ifdef PLATFORM_LINUX
+  if (!config.disableIoUring) { state->useUring = uring_create(state->uring, ASYNC_IO_MAX_READS); }
+#endif
+  if (state->useUring) {
+    LOGC_INFO(Platform, "[AsyncIO] Using io_uring");
+  } else {
+    state->pool.start(config.workerThreads);
+    LOGC_INFO(Platform, "[AsyncIO] Using %u worker threads", state->pool.thread_count());
+  }
+}
+
+void async_io_shutdown() {
+  if (!state) { return; }
+#ifdef PLATFORM_LINUX
+  if (state->useUring) {
+    while (state->inFlight > state->completedCount) {
+      uring_flush(state->uring);
+      sys_io_uring_enter(state->uring.fd, 0, 1, IORING_ENTER_GETEVENTS);
+      uring_reap(state->uring);
+    }
+  }
+#endif
+  if (!state->useUring) { state->pool.stop(); }
+  async_io_poll();
+#ifdef PLATFORM_LINUX
+  if (state->useUring) { uring_destroy(state->uring); }
+#endif
+  state->~AsyncIoState();
+  state = nullptr;
+}
+
+void async_io_poll() {
+#ifdef PLATFORM_LINUX
+  if (state->useUring) { uring_reap(state->uring); }
+#endif
+  u32 count = 0;
+  {
+    std::lock_guard guard(state->completedMutex);
+    count = state->completedCount;
+    memcpy(state->dispatching, state->completed, count * sizeof(u32));
+    state->completedCount = 0;
+  }
+
+  for (u32 i = 0; i < count; ++i) {
+    u32   index = state->dispatching[i];
+    auto &read  = state->reads[index];
+    close(read.fd);
+
+    FileReadResult result = {
+        .requestId = read.id,
+        .error     = read.error,
+        .bytesRead = read.done,
+        .dst       = read.dst,
+        .userData  = read.userData,
+    };
+    auto callback                        = read.callback;
+    read.id                              = 0;
+    state->freeSlots[state->freeCount++] = index;
+    state->inFlight--;
+
+    if (callback) { callback(result); }
+    EventContext context{};
+    context.u32[0] = result.requestId;
+    context.i32[1] = result.error;
+    context.u64[1] = result.bytesRead;
+    event_fire(EventCode::FileReadCompleted, nullptr, context);
+  }
+}
+
+u32 async_io_get_in_flight() { return state->inFlight; }
+
+u32 filesystem_read_async(CString          path,
+                          u64              offset,
+                          u64              size,
+                          void            *dst,
+                          PFN_on_file_read callback,
+                          void            *userData) {
+  if (state->freeCount == 0) {
+    LOGC_WARN(Platform, "[AsyncIO] Too many reads in flight, '%s' not queued", path);
+    return 0;
+  }
+  i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOGC_ERROR(Platform, "[AsyncIO] Failed to open '%s': %s", path, strerror(errno));
+    return 0;
+  }
+
+  u32 index = state->freeSlots[--state->freeCount];
+  if (++state->nextId == 0) { state->nextId = 1; } // 0 marks a failed request
+  state->reads[index] = {
+      .id       = state->nextId,
+      .fd       = fd,
+      .offset   = offset,
+      .size     = size,
+      .dst      = (u8 *) dst,
+      .callback = callback,
+      .userData = userData,
+  };
+  state->inFlight++;
+
+#ifdef PLATFORM_LINUX
+  if (state->useUring) {
+    uring_queue(state->uring, index);
+    uring_flush(state->uring);
+    return state->nextId;
+  }
+#endif
+  state->pool.submit(read_job, &state->reads[index]);
+  return state->nextId;
+}
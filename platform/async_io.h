@@ -0,0 +1,55 @@
+//
+// Created by Hongjian Zhu on 2022/10/28.
+//
+
+#pragma once
+
+#include "defines.h"
+
+static constexpr u32 ASYNC_IO_MAX_READS = 256; // Reads in flight at once
+
+struct FileReadResult {
+  u32   requestId;
+  i32   error; // errno of the failed read, 0 on success
+  u64   bytesRead;
+  void *dst;
+  void *userData;
+};
+
+// Called on the thread running `async_io_poll`
+typedef void (*PFN_on_file_read)(const FileReadResult &result);
+
+struct AsyncIoConfig {
+  // Threads of the fallback pool, 0 picks one per core
+  u32 workerThreads;
+  // Use the thread pool even where io_uring is available
+  bool disableIoUring;
+};
+
+void async_io_initialize(u64 *memorySize, void *pState, const AsyncIoConfig &config = {});
+// Waits for the reads in flight and dispatches their completions
+void async_io_shutdown();
+
+// Dispatches finished reads: calls their callbacks, then fires EventCode::FileReadCompleted. Call
+// once per frame from the main thread.
+void async_io_poll();
+
+u32 async_io_get_in_flight();
+
+/**
+ * Queues a read of `size` bytes at `offset` into `dst`, which has to stay valid until the read
+ * completes. Short reads only happen at the end of the file. Main thread only.
+ * @param path
+ * @param offset
+ * @param size
+ * @param dst
+ * @param callback Optional, the completion event is fired either way.
+ * @param userData Passed back in the FileReadResult.
+ * @return The request id, 0 if the file couldn't be opened or too many reads are in flight.
+ */
+u32 filesystem_read_async(CString          path,
+                          u64              offset,
+                          u64              size,
+                          void            *dst,
+                          PFN_on_file_read callback,
+                          void            *userData = nullptr);
@@ -0,0 +1,195 @@
+//
+// Created by Hongjian Zhu on 2022/10/31.
+//
+
+#include "platform/file_watcher.h"
+#include "event.h"
+#include "logging.h"
+#include "platform.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef PLATFORM_LINUX
+#include <sys/inotify.h>
+#endif
+
+struct WatchedDirectory {
+  i32  wd;
+  char path[256];   // As passed to inotify
+  char prefix[256]; // Relative to the directory given to `file_watcher_add`, "" for itself
+};
+
+// A change waiting for the file to settle
+struct PendingChange {
+  char path[256];
+  f64  lastTime;
+};
+
+struct FileWatcherState {
+  i32              fd;
+  WatchedDirectory directories[FILE_WATCHER_MAX_DIRECTORIES];
+  u32              directoryCount;
+  PendingChange    pending[FILE_WATCHER_MAX_CHANGES];
+  u32              pendingCount;
+  char             changes[FILE_WATCHER_MAX_CHANGES][256]; // Indexed by change id
+  u32              nextChangeId;
+};
+
+static FileWatcherState *state = nullptr;
+
+void file_watcher_initialize(u64 *memorySize, void *pState) {
+  *memorySize = sizeof(FileWatcherState);
+  if (!pState) { return; }
+  state     = (FileWatcherState *) pState;
+  state->fd = -1;
+#ifdef PLATFORM_LINUX
+  state->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (state->fd < 0) {
+    LOGC_WARN(Platform, "[FileWatcher] inotify unavailable: %s", strerror(errno));
+  }
+#endif
+}
+
+void file_watcher_shutdown() {
+  if (!state) { return; }
+  if (state->fd >= 0) { close(state->fd); } // Drops the watches along with it
+  state = nullptr;
+}
+
+#ifdef PLATFORM_LINUX
+// Returns false if the path doesn't fit, a truncated one would name some other file
+template <u64 N, typename... Args>
+static bool format_path(char (&dst)[N], CString format, Args... args) {
+  i32 length = snprintf(dst, N, format, args...);
+  if (length >= 0 && (u64) length < N) { return true; }
+  LOGC_WARN(Platform, "[FileWatcher] Path longer than %llu bytes skipped: '%s...'",
+            (unsigned long long) N - 1, dst);
+  return false;
+}
+
+static bool watch_directory(CString path, CString prefix) {
+  if (state->directoryCount == FILE_WATCHER_MAX_DIRECTORIES) {
+    LOGC_WARN(Platform, "[FileWatcher] Too many directories, '%s' not watched", path);
+    return false;
+  }
+  auto &directory = state->directories[state->directoryCount];
+  if (!format_path(directory.path, "%s", path) || !format_path(directory.prefix, "%s", prefix)) {
+    return false;
+  }
+  // Editors either write in place or write a temporary file and rename it over the original
+  i32 wd = inotify_add_watch(state->fd, path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+  if (wd < 0) {
+    LOGC_WARN(Platform, "[FileWatcher] Failed to watch '%s': %s", path, strerror(errno));
+    return false;
+  }
+  directory.wd = wd;
+  ++state->directoryCount;
+
+  // inotify isn't recursive
+  DIR *dir = opendir(path);
+  if (!dir) { return true; }
+  while (dirent *entry = readdir(dir)) {
+    if (entry->d_type != DT_DIR || entry->d_name[0] == '.') { continue; }
+    char childPath[256], childPrefix[256];
+    if (format_path(childPath, "%s/%s", path, entry->d_name) &&
+        format_path(childPrefix, "%s%s/", prefix, entry->d_name)) {
+      watch_directory(childPath, childPrefix);
+    }
+  }
+  closedir(dir);
+  return true;
+}
+
+static void add_pending(CString path, f64 now) {
+  for (u32 i = 0; i < state->pendingCount; ++i) {
+    if (strcmp(state->pending[i].path, path) == 0) {
+      state->pending[i].lastTime = now;
+      return;
+    }
+  }
+  if (state->pendingCount == FILE_WATCHER_MAX_CHANGES) { return; }
+  auto &change = state->pending[state->pendingCount];
+  if (!format_path(change.path, "%s", path)) { return; }
+  change.lastTime = now;
+  ++state->pendingCount;
+}
+
+static void read_events(f64 now) {
+  alignas(inotify_event) char buffer[4 * KiB];
+  for (;;) {
+    ssize_t length = read(state->fd, buffer, sizeof(buffer));
+    if (length <= 0) { return; } // EAGAIN once drained
+
+    for (char *p = buffer; p < buffer + length;) {
+      auto event = (const inotify_event *) p;
+      p += sizeof(inotify_event) + event->len;
+      if (event->len == 0) { continue; }
+
+      const WatchedDirectory *directory = nullptr;
+      for (u32 i = 0; i < state->directoryCount && !directory; ++i) {
+        if (state->directories[i].wd == event->wd) { directory = &state->directories[i]; }
+      }
+      if (!directory) { continue; }
+
+      if (event->mask & IN_ISDIR) {
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          char path[256], prefix[256];
+          if (format_path(path, "%s/%s", directory->path, event->name) &&
+              format_path(prefix, "%s%s/", directory->prefix, event->name)) {
+            watch_directory(path, prefix);
+          }
+        }
+        continue;
+      }
+      // A created file is reported again once it's closed. Hidden files are editor temporaries.
+      if ((event->mask & IN_CREATE) || event->name[0] == '.') { continue; }
+
+      char path[256];
+      if (format_path(path, "%s%s", directory->prefix, event->name)) { add_pending(path, now); }
+    }
+  }
+}
+#endif
+
+bool file_watcher_add(CString directory) {
+#ifdef PLATFORM_LINUX
+  if (state->fd < 0) { return false; }
+  if (!watch_directory(directory, "")) { return false; }
+  LOGC_INFO(Platform, "[FileWatcher] Watching '%s'", directory);
+  return true;
+#else
+  LOGC_WARN(Platform, "[FileWatcher] Not supported on this platform, '%s' not watched", directory);
+  return false;
+#endif
+}
+
+void file_watcher_poll() {
+#ifdef PLATFORM_LINUX
+  if (state->fd < 0 || state->directoryCount == 0) { return; }
+  f64 now = platform_get_absolute_time();
+  read_events(now);
+
+  for (u32 i = 0; i < state->pendingCount;) {
+    auto &change = state->pending[i];
+    if (now - change.lastTime < FILE_WATCHER_SETTLE_SECONDS) {
+      ++i;
+      continue;
+    }
+    u32 id = state->nextChangeId++;
+    memcpy(state->changes[id % FILE_WATCHER_MAX_CHANGES], change.path, sizeof(change.path));
+    change = state->pending[--state->pendingCount];
+
+    LOGC_DEBUG(Platform, "[FileWatcher] '%s' changed", file_watcher_get_path(id));
+    EventContext context{};
+    context.u32[0] = id;
+    event_fire(EventCode::FileChanged, nullptr, context);
+  }
+#endif
+}
+
+CString file_watcher_get_path(u32 changeId) {
+  return state->changes[changeId % FILE_WATCHER_MAX_CHANGES];
+}
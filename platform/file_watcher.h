@@ -0,0 +1,27 @@
+//
+// Created by Hongjian Zhu on 2022/10/31.
+//
+
+#pragma once
+
+#include "defines.h"
+
+static constexpr u32 FILE_WATCHER_MAX_DIRECTORIES = 64;
+static constexpr u32 FILE_WATCHER_MAX_CHANGES     = 64; // Paths kept for the posted events
+static constexpr f64 FILE_WATCHER_SETTLE_SECONDS  = 0.1;
+
+// Watches directories for files being written, created or moved in, inotify based. Not
+// supported on other platforms yet, directories can't be added there.
+void file_watcher_initialize(u64 *memorySize, void *pState);
+void file_watcher_shutdown();
+
+// Watches `directory` and its subdirectories, including ones created later
+bool file_watcher_add(CString directory);
+
+// Posts EventCode::FileChanged for each changed file once it's been left alone for
+// FILE_WATCHER_SETTLE_SECONDS, so editors saving in several steps trigger a single reload
+void file_watcher_poll();
+
+// Path of the changed file relative to the watched directory, e.g. "shaders/Builtin.vert.spv".
+// Overwritten after FILE_WATCHER_MAX_CHANGES further changes.
+CString file_watcher_get_path(u32 changeId);
@@ -7,13 +7,27 @@
 #include "memory.h"
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 bool filesystem_exists(CString path) {
   struct stat st {};
   return stat(path, &st) == 0;
 }
 
+bool filesystem_size(CString path, u64 *size) {
+  struct stat st {};
+  if (stat(path, &st) != 0) { return false; }
+  *size = (u64) st.st_size;
+  return true;
+}
+
+bool filesystem_rename(CString from, CString to) { return rename(from, to) == 0; }
+
+bool filesystem_remove(CString path) { return remove(path) == 0; }
+
 bool filesystem_open(CString path, FileMode mode, bool isBinary, FileHandle *out) {
   CString flags;
   if ((mode & FILE_MODE_READ) != 0 && (mode & FILE_MODE_WRITE) != 0) {
@@ -23,7 +37,7 @@ bool filesystem_open(CString path, FileMode mode, bool isBinary, FileHandle *out
   } else if ((mode & FILE_MODE_READ) == 0 && (mode & FILE_MODE_WRITE) != 0) {
     flags = isBinary ? "wb" : "w";
   } else {
-    LOG_ERROR("Invalid file mode when opening file: '%s'", path);
+    LOGC_ERROR(Platform, "Invalid file mode when opening file: '%s'", path);
     return false;
   }
 
@@ -73,6 +87,114 @@ bool filesystem_read_all(FileHandle *handle, u8 **dst, u64 *read) {
   return *read == size;
 }
 
+bool filesystem_map(CString path, FileView *view, u8 flags) {
+  *view  = {};
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) { return false; }
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (!S_ISREG(st.st_mode)) { // Pipes and devices report no size
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) { // Can't map zero bytes
+    close(fd);
+    return true;
+  }
+
+  int mapFlags = MAP_PRIVATE;
+#ifdef PLATFORM_LINUX
+  if ((flags & FILE_MAP_PREFETCH) != 0) { mapFlags |= MAP_POPULATE; }
+#endif
+  void *data = mmap(nullptr, st.st_size, PROT_READ, mapFlags, fd, 0);
+  close(fd); // The mapping keeps the file referenced
+  if (data == MAP_FAILED) {
+    LOGC_ERROR(Platform, "Failed to map file '%s'", path);
+    return false;
+  }
+
+  if ((flags & FILE_MAP_SEQUENTIAL) != 0) {
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+  } else if ((flags & FILE_MAP_RANDOM) != 0) {
+    madvise(data, st.st_size, MADV_RANDOM);
+  }
+#ifndef PLATFORM_LINUX
+  if ((flags & FILE_MAP_PREFETCH) != 0) { madvise(data, st.st_size, MADV_WILLNEED); }
+#endif
+
+  view->data = (const u8 *) data;
+  view->size = st.st_size;
+  return true;
+}
+
+void filesystem_unmap(FileView *view) {
+  if (view->data) { munmap((void *) view->data, view->size); }
+  *view = {};
+}
+
+bool line_reader_open(CString path, LineReader *out, bool map) {
+  *out = {};
+  if (map && filesystem_map(path, &out->view)) {
+    line_reader_init(out, out->view.data, out->view.size);
+    return true;
+  }
+  if (!filesystem_open(path, FILE_MODE_READ, true, &out->handle)) { return false; }
+  out->buffer = (char *) memory_allocate(LINE_READER_BUFFER_SIZE, MemoryTag::STRING);
+  out->cursor = out->buffer;
+  out->end    = out->buffer;
+  return true;
+}
+
+void line_reader_init(LineReader *out, const void *data, u64 size) {
+  out->cursor = (const char *) data;
+  out->end    = out->cursor + size;
+  out->eof    = true;
+}
+
+// Moves the unread bytes to the front of the buffer and fills up the rest, false at EOF
+static bool refill(LineReader *reader) {
+  if (reader->eof) { return false; }
+  u64 remaining = reader->end - reader->cursor;
+  memmove(reader->buffer, reader->cursor, remaining);
+  u64 read      = 0;
+  u64 available = LINE_READER_BUFFER_SIZE - remaining;
+  filesystem_read(&reader->handle, available, reader->buffer + remaining, &read);
+  reader->cursor = reader->buffer;
+  reader->end    = reader->buffer + remaining + read;
+  reader->eof    = read == 0;
+  return read > 0;
+}
+
+bool line_reader_next(LineReader *reader, StringView *line) {
+  const char *newline = utils::find_char(reader->cursor, reader->end, '\n');
+  while (newline == reader->end) {
+    u64  scanned = reader->end - reader->cursor;
+    bool full    = scanned == LINE_READER_BUFFER_SIZE;
+    if (full || !refill(reader)) {
+      newline = reader->end; // The buffer may have moved
+      break;
+    }
+    newline = utils::find_char(reader->cursor + scanned, reader->end, '\n');
+  }
+  if (reader->cursor == reader->end) { return false; }
+
+  line->ptr    = reader->cursor;
+  line->length = newline - reader->cursor;
+  if (line->length > 0 && line->ptr[line->length - 1] == '\r') { --line->length; }
+  reader->cursor = newline == reader->end ? newline : newline + 1;
+  return true;
+}
+
+void line_reader_close(LineReader *reader) {
+  filesystem_unmap(&reader->view);
+  if (reader->handle.handle) { filesystem_close(&reader->handle); }
+  if (reader->buffer) { memory_free(reader->buffer, LINE_READER_BUFFER_SIZE, MemoryTag::STRING); }
+  *reader = {};
+}
+
 bool filesystem_write(FileHandle *handle, u64 size, const void *src, u64 *written) {
   *written = fwrite(src, 1, size, (FILE *) handle->handle);
   if (*written != size) { return false; }
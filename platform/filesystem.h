@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "StringUtils.h"
 #include "defines.h"
 
 // Holds a handle to a file
@@ -16,14 +17,34 @@ enum FileMode : u8 {
   FILE_MODE_WRITE = 0x2,
 };
 
+// Read-only view of a whole file mapped into memory
+struct FileView {
+  const u8 *data; // Page aligned, null for an empty file
+  u64       size;
+};
+
+enum FileMapFlags : u8 {
+  FILE_MAP_SEQUENTIAL = 0x1, // Read front to back, read ahead aggressively
+  FILE_MAP_RANDOM     = 0x2, // Scattered access, don't read ahead
+  FILE_MAP_PREFETCH   = 0x4, // Fault the pages in up front instead of on first access
+};
+
 bool filesystem_exists(CString path);
 
+bool filesystem_size(CString path, u64 *size);
+
+// Replaces `to` if it exists
+bool filesystem_rename(CString from, CString to);
+
+bool filesystem_remove(CString path);
+
 bool filesystem_open(CString path, FileMode mode, bool isBinary, FileHandle *out);
 
 void filesystem_close(FileHandle *handle);
 
 /**
- * Reads up to a newline or EOF. Allocates *dst, which must be freed by the caller.
+ * Reads up to a newline or EOF. Allocates *dst, which must be freed by the caller. Prefer a
+ * LineReader, which doesn't allocate.
  * @param handle
  * @param line A pointer to a character array which will be allocated and populated.
  * @return
@@ -58,6 +79,44 @@ bool filesystem_read(FileHandle *handle, u64 size, void *dst, u64 *read);
  */
 bool filesystem_read_all(FileHandle *handle, u8 **dst, u64 *read);
 
+/**
+ * Maps a file read-only, the data is shared with the page cache instead of copied to the heap.
+ * @param path
+ * @param view Populated with the mapping, release it with `filesystem_unmap`.
+ * @param flags A combination of FileMapFlags describing how the data will be accessed.
+ * @return
+ */
+bool filesystem_map(CString   path,
+                    FileView *view,
+                    u8        flags = FILE_MAP_SEQUENTIAL | FILE_MAP_PREFETCH);
+
+void filesystem_unmap(FileView *view);
+
+static constexpr u64 LINE_READER_BUFFER_SIZE = 64 * KiB;
+
+// Iterates the lines of a file, handing out views into the mapped file or its read buffer
+// instead of copying each line
+struct LineReader {
+  FileView    view;   // Set when the file is mapped
+  FileHandle  handle; // Set when the file is read in chunks
+  char       *buffer; // LINE_READER_BUFFER_SIZE bytes when the file is read in chunks
+  const char *cursor;
+  const char *end;
+  bool        eof;
+};
+
+// Maps the file if `map` is set and that works, otherwise reads it in chunks, e.g. for pipes
+bool line_reader_open(CString path, LineReader *out, bool map = true);
+
+// Iterates text already in memory, e.g. an asset, which must outlive the reader
+void line_reader_init(LineReader *out, const void *data, u64 size);
+
+// The line excludes its "\n" or "\r\n" and is valid until the next call. When reading in chunks,
+// lines longer than LINE_READER_BUFFER_SIZE are split.
+bool line_reader_next(LineReader *reader, StringView *line);
+
+void line_reader_close(LineReader *reader);
+
 /**
  * Writes provided data to the file.
  * @param handle
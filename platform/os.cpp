@@ -0,0 +1,36 @@
+//
+// Created by Hongjian Zhu on 2022/11/6.
+//
+
+// The parts of the platform layer that don't need a window, kept apart from platform.cpp so tools
+// and benchmarks can link them without GLFW
+
+#include "platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+
+void *platform_allocate(u64 size, bool aligned) { return malloc(size); }
+
+void platform_free(void *block, bool aligned) { free(block); }
+
+void *platform_zero_memory(void *block, u64 size) { return platform_set_memory(block, 0, size); }
+
+void *platform_copy_memory(void *dst, const void *src, u64 size) { return memcpy(dst, src, size); }
+
+void *platform_set_memory(void *dst, i32 value, u64 size) { return memset(dst, value, size); }
+
+void platform_console_write(CString message) { fprintf(stdout, "%s", message); }
+
+void platform_console_write_error(CString message) { fprintf(stderr, "%s", message); }
+
+u64 platform_get_peak_resident_memory() {
+  rusage usage = {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if PLATFORM_APPLE
+  return (u64) usage.ru_maxrss; // Bytes
+#else
+  return (u64) usage.ru_maxrss * KiB;
+#endif
+}
@@ -0,0 +1,249 @@
+//
+// Created by Hongjian Zhu on 2022/11/7.
+//
+
+#include "platform/perf_counters.h"
+#include "logging.h"
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#ifdef PLATFORM_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static constexpr u32 PERF_EVENT_COUNT = 4; // In the order of PerfCounters' members
+
+struct ZoneSlot {
+  std::atomic<CString> name;
+  std::atomic<u64>     count;
+  std::atomic<u64>     values[PERF_EVENT_COUNT];
+};
+
+// One perf event group per thread, the cycles counter leads
+struct ThreadCounters {
+  i32               fds[PERF_EVENT_COUNT];
+  std::atomic<bool> open;
+  // Written by the owning thread only, slots stay with their names when threads come and go
+  ZoneSlot          zones[PERF_COUNTERS_MAX_ZONES];
+};
+
+struct PerfCountersState {
+  std::mutex     mutex; // Attaching, detaching and reading across threads
+  ThreadCounters threads[PERF_COUNTERS_MAX_THREADS];
+  PerfCounters   detached; // Final counts of the threads that went away
+};
+
+static PerfCountersState *state = nullptr;
+
+std::atomic<bool> perfCountersEnabled      = false;
+std::atomic<bool> perfCountersZonesEnabled = false;
+
+static thread_local ThreadCounters *threadCounters = nullptr;
+
+#ifdef PLATFORM_LINUX
+static i32 open_event(u64 config, i32 groupFd) {
+  perf_event_attr attr = {};
+  attr.size            = sizeof(attr);
+  attr.type            = PERF_TYPE_HARDWARE;
+  attr.config          = config;
+  attr.disabled        = groupFd == -1; // The group starts once complete
+  attr.exclude_kernel  = 1;             // Allowed without privileges, and what we care about
+  attr.exclude_hv      = 1;
+  attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // This thread, on any CPU
+  return (i32) syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void close_group(ThreadCounters *thread) {
+  for (i32 &fd : thread->fds) {
+    if (fd >= 0) { close(fd); }
+    fd = -1;
+  }
+}
+
+static bool open_group(ThreadCounters *thread) {
+  const u64 configs[PERF_EVENT_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  };
+  for (i32 &fd : thread->fds) {
+    fd = -1;
+  }
+  for (u32 i = 0; i < PERF_EVENT_COUNT; ++i) {
+    thread->fds[i] = open_event(configs[i], i == 0 ? -1 : thread->fds[0]);
+    if (thread->fds[i] < 0) {
+      close_group(thread);
+      return false;
+    }
+  }
+  ioctl(thread->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(thread->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+static bool read_group(ThreadCounters *thread, PerfCounters *out) {
+  struct {
+    u64 count;
+    u64 timeEnabled;
+    u64 timeRunning;
+    u64 values[PERF_EVENT_COUNT];
+  } data;
+  if (read(thread->fds[0], &data, sizeof(data)) != (ssize_t) sizeof(data)) { return false; }
+  // Scaled up if the group had to share the PMU with other events
+  f64 scale = data.timeRunning && data.timeRunning < data.timeEnabled
+                  ? (f64) data.timeEnabled / (f64) data.timeRunning
+                  : 1.0;
+  *out = {
+      .cycles       = (u64) ((f64) data.values[0] * scale),
+      .instructions = (u64) ((f64) data.values[1] * scale),
+      .cacheMisses  = (u64) ((f64) data.values[2] * scale),
+      .branchMisses = (u64) ((f64) data.values[3] * scale),
+  };
+  return true;
+}
+#else
+static void close_group(ThreadCounters *thread) {}
+static bool open_group(ThreadCounters *thread) { return false; }
+static bool read_group(ThreadCounters *thread, PerfCounters *out) { return false; }
+#endif
+
+static void accumulate(PerfCounters &total, const PerfCounters &counters) {
+  total.cycles += counters.cycles;
+  total.instructions += counters.instructions;
+  total.cacheMisses += counters.cacheMisses;
+  total.branchMisses += counters.branchMisses;
+}
+
+void perf_counters_initialize(u64 *memorySize, void *pState, const PerfCountersConfig &config) {
+  *memorySize = sizeof(PerfCountersState);
+  if (!pState) { return; }
+  state = new (pState) PerfCountersState();
+  if (!config.enabled && !config.zones) { return; }
+
+  // Probe with a throwaway group, the threads open their own
+  ThreadCounters probe;
+  if (!open_group(&probe)) {
+#ifdef PLATFORM_LINUX
+    LOGC_WARN(Platform, "[PerfCounters] Hardware counters unavailable: %s", strerror(errno));
+#else
+    LOGC_WARN(Platform, "[PerfCounters] Hardware counters are only supported on Linux");
+#endif
+    return;
+  }
+  close_group(&probe);
+  perfCountersEnabled.store(true, std::memory_order_relaxed);
+  perfCountersZonesEnabled.store(config.zones, std::memory_order_relaxed);
+  LOGC_INFO(Platform, "[PerfCounters] Counting cycles, instructions, cache and branch misses");
+}
+
+void perf_counters_shutdown() {
+  if (!state) { return; }
+  perfCountersEnabled.store(false, std::memory_order_relaxed);
+  perfCountersZonesEnabled.store(false, std::memory_order_relaxed);
+  for (auto &thread : state->threads) {
+    if (thread.open.load(std::memory_order_relaxed)) { close_group(&thread); }
+  }
+  state->~PerfCountersState();
+  state = nullptr;
+}
+
+void perf_counters_attach_thread() {
+  if (!perf_counters_enabled() || threadCounters) { return; }
+  std::lock_guard guard(state->mutex);
+  for (auto &thread : state->threads) {
+    if (thread.open.load(std::memory_order_relaxed)) { continue; }
+    if (!open_group(&thread)) {
+      LOGC_WARN(Platform, "[PerfCounters] Failed to open the thread's counters");
+      return;
+    }
+    thread.open.store(true, std::memory_order_relaxed);
+    threadCounters = &thread;
+    return;
+  }
+  LOGC_WARN(Platform, "[PerfCounters] No slot left, %u threads counted", PERF_COUNTERS_MAX_THREADS);
+}
+
+void perf_counters_detach_thread() {
+  if (!threadCounters || !state) { return; }
+  std::lock_guard guard(state->mutex);
+  PerfCounters counters = {};
+  if (read_group(threadCounters, &counters)) { accumulate(state->detached, counters); }
+  close_group(threadCounters);
+  threadCounters->open.store(false, std::memory_order_relaxed);
+  threadCounters = nullptr;
+}
+
+bool perf_counters_read(PerfCounters *out) {
+  return threadCounters && read_group(threadCounters, out);
+}
+
+bool perf_counters_read_all(PerfCounters *out) {
+  if (!perf_counters_enabled()) { return false; }
+  std::lock_guard guard(state->mutex);
+  *out = state->detached;
+  for (auto &thread : state->threads) {
+    PerfCounters counters = {};
+    if (thread.open.load(std::memory_order_relaxed) && read_group(&thread, &counters)) {
+      accumulate(*out, counters);
+    }
+  }
+  return true;
+}
+
+void perf_counters_record_zone(CString name, const PerfCounters &start) {
+  PerfCounters end = {};
+  if (!perf_counters_read(&end)) { return; }
+  auto delta = perf_counters_delta(start, end);
+
+  for (auto &zone : threadCounters->zones) {
+    CString zoneName = zone.name.load(std::memory_order_relaxed);
+    if (!zoneName) {
+      zone.name.store(name, std::memory_order_release);
+    } else if (zoneName != name) {
+      continue;
+    }
+    zone.count.fetch_add(1, std::memory_order_relaxed);
+    zone.values[0].fetch_add(delta.cycles, std::memory_order_relaxed);
+    zone.values[1].fetch_add(delta.instructions, std::memory_order_relaxed);
+    zone.values[2].fetch_add(delta.cacheMisses, std::memory_order_relaxed);
+    zone.values[3].fetch_add(delta.branchMisses, std::memory_order_relaxed);
+    return;
+  }
+}
+
+u32 perf_counters_get_zones(PerfZoneCounters *out, u32 capacity) {
+  if (!state) { return 0; }
+  u32 count = 0;
+  for (auto &thread : state->threads) {
+    for (auto &zone : thread.zones) {
+      CString name = zone.name.load(std::memory_order_acquire);
+      if (!name) { break; }
+      PerfCounters counters = {
+          .cycles       = zone.values[0].load(std::memory_order_relaxed),
+          .instructions = zone.values[1].load(std::memory_order_relaxed),
+          .cacheMisses  = zone.values[2].load(std::memory_order_relaxed),
+          .branchMisses = zone.values[3].load(std::memory_order_relaxed),
+      };
+      // Merged by name across threads
+      u32 i = 0;
+      while (i < count && out[i].name != name) {
+        ++i;
+      }
+      if (i == count) {
+        if (count == capacity) { continue; }
+        out[count++] = {.name = name};
+      }
+      out[i].count += zone.count.load(std::memory_order_relaxed);
+      accumulate(out[i].counters, counters);
+    }
+  }
+  return count;
+}
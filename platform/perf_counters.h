@@ -0,0 +1,72 @@
+//
+// Created by Hongjian Zhu on 2022/11/7.
+//
+
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+
+static constexpr u32 PERF_COUNTERS_MAX_THREADS = 32;
+static constexpr u32 PERF_COUNTERS_MAX_ZONES   = 64; // Distinct zone names counted per thread
+
+struct PerfCounters {
+  u64 cycles;
+  u64 instructions;
+  u64 cacheMisses; // Last level
+  u64 branchMisses;
+};
+
+struct PerfZoneCounters {
+  CString      name;
+  u64          count; // Times the zone was entered
+  PerfCounters counters;
+};
+
+struct PerfCountersConfig {
+  bool enabled;
+  // Also count each PROFILE_SCOPE zone, at the cost of two reads of the counters per zone
+  bool zones;
+};
+
+/**
+ * Hardware counters of the user space code, per thread, through perf_event_open. Only on Linux,
+ * and only where the kernel allows it (perf_event_paranoid <= 2) and a PMU is exposed, which
+ * most VMs don't. Everything is a no-op when unavailable.
+ */
+void perf_counters_initialize(u64 *memorySize, void *pState, const PerfCountersConfig &config = {});
+void perf_counters_shutdown();
+
+extern std::atomic<bool> perfCountersEnabled;
+extern std::atomic<bool> perfCountersZonesEnabled;
+
+inline bool perf_counters_enabled() { return perfCountersEnabled.load(std::memory_order_relaxed); }
+inline bool perf_counters_zones_enabled() {
+  return perfCountersZonesEnabled.load(std::memory_order_relaxed);
+}
+
+// Starts counting the calling thread, threads without a group aren't counted. Detach before the
+// thread exits.
+void perf_counters_attach_thread();
+void perf_counters_detach_thread();
+
+// The calling thread's counts so far
+bool perf_counters_read(PerfCounters *out);
+
+// The counts of every thread attached so far, detached ones included
+bool perf_counters_read_all(PerfCounters *out);
+
+// Adds what was counted on the calling thread since `start` to zone `name`, see ProfileZone
+void perf_counters_record_zone(CString name, const PerfCounters &start);
+
+// Zones summed over all threads, returns how many were written to `out`
+u32 perf_counters_get_zones(PerfZoneCounters *out, u32 capacity);
+
+inline PerfCounters perf_counters_delta(const PerfCounters &from, const PerfCounters &to) {
+  return {
+      .cycles       = to.cycles - from.cycles,
+      .instructions = to.instructions - from.instructions,
+      .cacheMisses  = to.cacheMisses - from.cacheMisses,
+      .branchMisses = to.branchMisses - from.branchMisses,
+  };
+}
@@ -0,0 +1,132 @@
+//
+// Created by Hongjian Zhu on 2022/11/1.
+//
+
+#include "platform/timer.h"
+#include "logging.h"
+#include "platform.h"
+#include <cerrno>
+#include <ctime>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// ns = baseNs + (counter - baseCounter) * multiplier >> 32
+struct CycleCounter {
+  bool enabled;
+  u64  baseCounter;
+  u64  baseNs;
+  u64  multiplier; // Nanoseconds per tick in 32.32 fixed point
+};
+
+static CycleCounter counter = {};
+
+static u64 os_time_ns() {
+  timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (u64) ts.tv_sec * 1000000000ull + (u64) ts.tv_nsec;
+}
+
+#if defined(__x86_64__)
+static u64 read_counter() { return __rdtsc(); }
+
+// Without an invariant TSC the rate changes with P-states and the counter stops in deep C-states
+static bool counter_is_reliable() {
+  u32 eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) { return false; }
+  return edx & (1u << 8);
+}
+#elif defined(__aarch64__)
+static u64 read_counter() {
+  u64 value;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value)::"memory");
+  return value;
+}
+
+// The generic timer runs at a fixed rate by design
+static bool counter_is_reliable() { return true; }
+#else
+static u64  read_counter() { return 0; }
+static bool counter_is_reliable() { return false; }
+#endif
+
+// Measures the counter against the OS clock, long enough for the read jitter not to matter
+static u64 calibrate(u64 *baseCounter, u64 *baseNs) {
+  constexpr u64 calibrationNs = 20 * 1000000ull;
+
+  u64 startNs      = os_time_ns();
+  u64 startCounter = read_counter();
+  u64 nowNs        = startNs;
+  while (nowNs - startNs < calibrationNs) {
+    nowNs = os_time_ns();
+  }
+  u64 nowCounter = read_counter();
+
+  u64 ticks = nowCounter - startCounter;
+  if (ticks == 0) { return 0; }
+  *baseCounter = nowCounter;
+  *baseNs      = nowNs;
+  return (u64) (((unsigned __int128) (nowNs - startNs) << 32) / ticks);
+}
+
+u64 platform_get_time_ns() {
+  if (counter.enabled) {
+    u64 ticks = read_counter() - counter.baseCounter;
+    return counter.baseNs + (u64) (((unsigned __int128) ticks * counter.multiplier) >> 32);
+  }
+  return os_time_ns();
+}
+
+bool platform_timer_initialize(bool useCycleCounter) {
+  counter.enabled = false;
+  if (!useCycleCounter) { return false; }
+  if (!counter_is_reliable()) {
+    LOGC_WARN(Platform, "No invariant cycle counter, timing with clock_gettime");
+    return false;
+  }
+
+  CycleCounter calibrated = {.enabled = true};
+  calibrated.multiplier   = calibrate(&calibrated.baseCounter, &calibrated.baseNs);
+  if (calibrated.multiplier == 0) {
+    LOGC_WARN(Platform, "Cycle counter isn't advancing, timing with clock_gettime");
+    return false;
+  }
+  counter = calibrated;
+  LOGC_INFO(Platform,
+            "Timing with the cycle counter at %.3f MHz",
+            (f64) (1ull << 32) * 1000.0 / (f64) counter.multiplier);
+  return true;
+}
+
+f64 platform_get_absolute_time() { return (f64) platform_get_time_ns() * 1e-9; }
+
+void platform_sleep(u64 ms) {
+  timespec ts = {.tv_sec = (time_t) (ms / 1000), .tv_nsec = (long) (ms % 1000) * 1000000};
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {} // Resumes with the time left
+}
+
+void platform_sleep_until_ns(u64 deadline) {
+  u64 now = platform_get_time_ns();
+  if (deadline <= now) { return; }
+  u64 duration = deadline - now;
+#ifdef PLATFORM_LINUX
+  // Our clock may not be one clock_nanosleep accepts, rebase the deadline onto CLOCK_MONOTONIC.
+  // Absolute, so a sleep resumed after a signal doesn't drift.
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  u64 target = (u64) ts.tv_sec * 1000000000ull + (u64) ts.tv_nsec + duration;
+  ts.tv_sec  = (time_t) (target / 1000000000ull);
+  ts.tv_nsec = (long) (target % 1000000000ull);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+  timespec ts = {.tv_sec = (time_t) (duration / 1000000000ull),
+                 .tv_nsec = (long) (duration % 1000000000ull)};
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+#endif
+}
@@ -0,0 +1,21 @@
+//
+// Created by Hongjian Zhu on 2022/11/1.
+//
+
+#pragma once
+
+#include "defines.h"
+
+// Monotonic nanoseconds since an arbitrary point, not slewed by NTP. Reads
+// clock_gettime(CLOCK_MONOTONIC_RAW) unless the cycle counter fast path is enabled.
+u64 platform_get_time_ns();
+
+// With `useCycleCounter`, timestamps are read from the invariant TSC on x86-64 or the generic
+// timer on arm64, calibrated against the OS clock, skipping the clock_gettime call. Falls back to
+// the OS clock where the counter isn't reliable. Timestamps stay continuous across the switch.
+// Returns whether the fast path is in use.
+bool platform_timer_initialize(bool useCycleCounter);
+
+// Sleeps until platform_get_time_ns() is at least around `deadline`. The OS may wake the thread
+// late by its timer slack and scheduling latency, spin after it for precision.
+void platform_sleep_until_ns(u64 deadline);
@@ -0,0 +1,271 @@
+//
+// Created by Hongjian Zhu on 2022/11/4.
+//
+
+#include "renderer/GpuProfiler.h"
+#include "core/FrameStats.h"
+#include "logging.h"
+#include "platform/timer.h"
+#include "renderer/command_buffer.h"
+#include <ctime>
+#include <new>
+
+static constexpr u32 QUERIES_PER_FRAME      = GPU_PROFILER_MAX_ZONES * 2; // Begin and end
+static constexpr u32 CALIBRATION_QUERY      = GPU_PROFILER_MAX_FRAMES * QUERIES_PER_FRAME;
+static constexpr u64 RECALIBRATION_INTERVAL = 256; // Frames, the clocks drift apart slowly
+static constexpr f64 AVERAGE_WEIGHT         = 1.0 / 16;
+// Calibrated samples the driver couldn't take closer together than this are retried, then skipped
+static constexpr u64 MAX_CALIBRATION_DEVIATION_NS = 20 * 1000;
+static constexpr u32 CALIBRATION_ATTEMPTS         = 4;
+
+struct FrameQueries {
+  CString names[GPU_PROFILER_MAX_ZONES];
+  u32     zoneCount;
+  bool    recorded; // Since the last read back
+};
+
+// A GPU tick and the CPU time it was taken at, zones are placed relative to it
+struct Calibration {
+  u64 ticks;
+  u64 timeNs;
+};
+
+struct GpuProfilerState {
+  VkQueryPool  pool;
+  FrameQueries frames[GPU_PROFILER_MAX_FRAMES];
+  f64          nsPerTick;
+  u32          validBits;
+  Calibration  calibration;
+  u64          calibratedFrame;
+  i32          track; // Of the CPU profiler
+
+  PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps; // Null without the extension
+
+  GpuZoneTiming timings[GPU_PROFILER_MAX_ZONES];
+  u32           timingCount;
+};
+
+static GpuProfilerState *state = nullptr;
+
+// Ticks elapsed from `from` to `to`, negative if `to` came first, across counter wraparound
+static i64 tick_delta(u64 from, u64 to) {
+  u32 shift = 64 - state->validBits;
+  return (i64) ((to - from) << shift) >> shift;
+}
+
+static u64 to_cpu_time(u64 ticks) {
+  auto &calibration = state->calibration;
+  return calibration.timeNs + (u64) ((f64) tick_delta(calibration.ticks, ticks) * state->nsPerTick);
+}
+
+#ifdef PLATFORM_LINUX
+// Whether the driver can read the device's and the host's clock together
+static bool host_time_domain_supported(Context *context) {
+  auto get_time_domains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+      vkGetInstanceProcAddr(context->instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+  if (!get_time_domains) { return false; }
+  auto physicalDevice = context->device.physicalDevice;
+  u32  domainCount    = 0;
+  if (get_time_domains(physicalDevice, &domainCount, nullptr) != VK_SUCCESS) { return false; }
+  VkTimeDomainEXT domains[domainCount];
+  if (get_time_domains(physicalDevice, &domainCount, domains) != VK_SUCCESS) { return false; }
+  bool device = false, host = false;
+  for (u32 i = 0; i < domainCount; ++i) {
+    device |= domains[i] == VK_TIME_DOMAIN_DEVICE_EXT;
+    host |= domains[i] == VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+  }
+  return device && host;
+}
+
+// CLOCK_MONOTONIC_RAW read between two reads of our clock, which may be the cycle counter
+static i64 host_clock_offset() {
+  timespec ts;
+  u64      before = platform_get_time_ns();
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  u64 after = platform_get_time_ns();
+  u64 raw   = (u64) ts.tv_sec * 1000000000ull + (u64) ts.tv_nsec;
+  return (i64) (before + (after - before) / 2) - (i64) raw;
+}
+
+// The driver reads the GPU tick and CLOCK_MONOTONIC_RAW together, the latter is then moved onto
+// our clock. Fails if no sample came within MAX_CALIBRATION_DEVIATION_NS.
+static bool calibrate_with_extension(Context *context) {
+  VkCalibratedTimestampInfoEXT infos[2] = {{VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT},
+                                           {VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT}};
+  infos[0].timeDomain                   = VK_TIME_DOMAIN_DEVICE_EXT;
+  infos[1].timeDomain                   = VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+
+  for (u32 attempt = 0; attempt < CALIBRATION_ATTEMPTS; ++attempt) {
+    u64 timestamps[2] = {};
+    u64 deviation     = 0;
+    if (state->get_calibrated_timestamps(
+            context->device.handle, 2, infos, timestamps, &deviation) != VK_SUCCESS) {
+      return false;
+    }
+    if (deviation > MAX_CALIBRATION_DEVIATION_NS) { continue; }
+    state->calibration = {timestamps[0], (u64) ((i64) timestamps[1] + host_clock_offset())};
+    return true;
+  }
+  return false;
+}
+#else
+// There's no host time domain to go with ours, see platform/timer.cpp
+static bool host_time_domain_supported(Context *context) { return false; }
+static bool calibrate_with_extension(Context *context) { return false; }
+#endif
+
+// Without the extension, a timestamp written by an otherwise empty submission has to do. It lands
+// somewhere between the submit and the wait returning, so this stalls the queue and is done once.
+static void calibrate_with_submission(Context *context) {
+  auto          device = context->device.handle;
+  CommandBuffer commandBuffer;
+  command_buffer_allocate_and_begin_single_use(
+      context, context->device.graphicsCommandPool, &commandBuffer);
+  vkCmdResetQueryPool(commandBuffer.handle, state->pool, CALIBRATION_QUERY, 1);
+  vkCmdWriteTimestamp(
+      commandBuffer.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, state->pool, CALIBRATION_QUERY);
+  u64 before = platform_get_time_ns();
+  command_buffer_end_single_use(
+      context, context->device.graphicsCommandPool, &commandBuffer, context->device.graphicsQueue);
+  u64 after = platform_get_time_ns();
+
+  u64 ticks = 0;
+  VK_CHECK(vkGetQueryPoolResults(device,
+                                 state->pool,
+                                 CALIBRATION_QUERY,
+                                 1,
+                                 sizeof(ticks),
+                                 &ticks,
+                                 sizeof(ticks),
+                                 VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+  state->calibration = {ticks, before + (after - before) / 2};
+}
+
+static void update_timing(CString name, f64 ms) {
+  for (u32 i = 0; i < state->timingCount; ++i) {
+    auto &timing = state->timings[i];
+    if (timing.name != name) { continue; }
+    timing.milliseconds = ms;
+    timing.averageMilliseconds += (ms - timing.averageMilliseconds) * AVERAGE_WEIGHT;
+    return;
+  }
+  if (state->timingCount < GPU_PROFILER_MAX_ZONES) {
+    state->timings[state->timingCount++] = {name, ms, ms};
+  }
+}
+
+static void read_back(Context *context, FrameQueries &frame, u32 firstQuery) {
+  u64  ticks[QUERIES_PER_FRAME];
+  auto result = vkGetQueryPoolResults(context->device.handle,
+                                      state->pool,
+                                      firstQuery,
+                                      frame.zoneCount * 2,
+                                      sizeof(ticks),
+                                      ticks,
+                                      sizeof(u64),
+                                      VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) { return; } // A zone that was never ended, nothing to trust
+
+  if (state->get_calibrated_timestamps &&
+      context->frameNumber >= state->calibratedFrame + RECALIBRATION_INTERVAL) {
+    if (calibrate_with_extension(context)) { state->calibratedFrame = context->frameNumber; }
+  }
+
+  u64 frameTicks = 0; // From the first zone's begin to the last end, the frame's GPU time
+  for (u32 i = 0; i < frame.zoneCount; ++i) {
+    u64 begin = ticks[i * 2];
+    u64 end   = ticks[i * 2 + 1];
+    profiler_record_track_zone(state->track, frame.names[i], to_cpu_time(begin), to_cpu_time(end));
+    update_timing(frame.names[i], (f64) tick_delta(begin, end) * state->nsPerTick * 1e-6);
+    i64 span = tick_delta(ticks[0], end);
+    if (span > (i64) frameTicks) { frameTicks = (u64) span; }
+  }
+  frame_stats_add(FrameMetric::Gpu, (u64) ((f64) frameTicks * state->nsPerTick));
+}
+
+void gpu_profiler_initialize(u64 *memorySize, void *pState, Context *context) {
+  *memorySize = sizeof(GpuProfilerState);
+  if (!pState) { return; }
+  auto &device = context->device;
+  f32   period = device.properties.limits.timestampPeriod;
+  if (device.timestampValidBits == 0 || period <= 0) {
+    LOGC_WARN(Renderer, "[GpuProfiler] The graphics queue can't write timestamps, disabled");
+    return;
+  }
+  ASSERT(context->swapchain.maxFramesInFlight <= GPU_PROFILER_MAX_FRAMES);
+
+  state            = new (pState) GpuProfilerState();
+  state->nsPerTick = period;
+  state->validBits = device.timestampValidBits;
+  state->track     = profiler_create_track("GPU");
+
+  VkQueryPoolCreateInfo createInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  createInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+  createInfo.queryCount            = CALIBRATION_QUERY + 1;
+  VK_CHECK(vkCreateQueryPool(device.handle, &createInfo, context->allocator, &state->pool));
+
+  if (device.calibratedTimestamps && host_time_domain_supported(context)) {
+    state->get_calibrated_timestamps = (PFN_vkGetCalibratedTimestampsEXT) vkGetDeviceProcAddr(
+        device.handle, "vkGetCalibratedTimestampsEXT");
+  }
+  if (!state->get_calibrated_timestamps || !calibrate_with_extension(context)) {
+    state->get_calibrated_timestamps = nullptr;
+    calibrate_with_submission(context);
+  }
+  state->calibratedFrame = context->frameNumber;
+  LOGC_DEBUG(Renderer,
+             "[GpuProfiler] %u valid bits, %.3f ns per tick, %s calibration",
+             state->validBits,
+             state->nsPerTick,
+             state->get_calibrated_timestamps ? "periodic" : "one-off");
+}
+
+void gpu_profiler_shutdown(Context *context) {
+  if (!state) { return; }
+  for (u32 i = 0; i < state->timingCount; ++i) {
+    LOGC_INFO(Renderer,
+              "[GpuProfiler] %s: %.3f ms on average",
+              state->timings[i].name,
+              state->timings[i].averageMilliseconds);
+  }
+  vkDestroyQueryPool(context->device.handle, state->pool, context->allocator);
+  state->~GpuProfilerState();
+  state = nullptr;
+}
+
+void gpu_profiler_begin_frame(Context *context, VkCommandBuffer commandBuffer) {
+  if (!state) { return; }
+  auto &frame      = state->frames[context->currentFrame];
+  u32   firstQuery = (u32) context->currentFrame * QUERIES_PER_FRAME;
+  if (frame.recorded && frame.zoneCount > 0) { read_back(context, frame, firstQuery); }
+  vkCmdResetQueryPool(commandBuffer, state->pool, firstQuery, QUERIES_PER_FRAME);
+  frame.zoneCount = 0;
+  frame.recorded  = true;
+}
+
+u32 gpu_profiler_begin(Context *context, VkCommandBuffer commandBuffer, CString name) {
+  if (!state) { return UINT32_MAX; }
+  auto &frame = state->frames[context->currentFrame];
+  if (frame.zoneCount == GPU_PROFILER_MAX_ZONES) { return UINT32_MAX; }
+  u32 zone          = frame.zoneCount++;
+  frame.names[zone] = name;
+  vkCmdWriteTimestamp(commandBuffer,
+                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                      state->pool,
+                      (u32) context->currentFrame * QUERIES_PER_FRAME + zone * 2);
+  return zone;
+}
+
+void gpu_profiler_end(Context *context, VkCommandBuffer commandBuffer, u32 zone) {
+  if (!state || zone == UINT32_MAX) { return; }
+  vkCmdWriteTimestamp(commandBuffer,
+                      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      state->pool,
+                      (u32) context->currentFrame * QUERIES_PER_FRAME + zone * 2 + 1);
+}
+
+u32 gpu_profiler_get_timings(const GpuZoneTiming **timings) {
+  if (!state) { return 0; }
+  *timings = state->timings;
+  return state->timingCount;
+}
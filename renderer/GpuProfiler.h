@@ -0,0 +1,56 @@
+//
+// Created by Hongjian Zhu on 2022/11/4.
+//
+
+#pragma once
+
+#include "core/Profiler.h"
+#include "renderer/types.h"
+
+static constexpr u32 GPU_PROFILER_MAX_ZONES  = 32; // Per frame
+static constexpr u32 GPU_PROFILER_MAX_FRAMES = 3;  // In flight, see ObjectShader
+
+struct GpuZoneTiming {
+  CString name;
+  f64     milliseconds;        // Of the latest frame read back
+  f64     averageMilliseconds; // Moving average over roughly the last 16 frames
+};
+
+// Timestamp queries around the zones recorded into each frame's command buffer. A frame's results
+// are read back when its queries come up for reuse, `maxFramesInFlight` frames later, once its
+// fence has been waited on, so reading never stalls. Zones also go to the profiler's GPU track,
+// moved onto the CPU clock. Disabled if the graphics queue can't write timestamps.
+void gpu_profiler_initialize(u64 *memorySize, void *pState, Context *context);
+void gpu_profiler_shutdown(Context *context);
+
+// Reads back what the current frame's queries measured last time and resets them. Called once the
+// frame's fence has been waited on, at the start of its command buffer, outside a render pass.
+void gpu_profiler_begin_frame(Context *context, VkCommandBuffer commandBuffer);
+
+// Returns the zone to end, zones past GPU_PROFILER_MAX_ZONES in a frame are dropped
+u32  gpu_profiler_begin(Context *context, VkCommandBuffer commandBuffer, CString name);
+void gpu_profiler_end(Context *context, VkCommandBuffer commandBuffer, u32 zone);
+
+// One per zone name, in the order they were first read back
+u32 gpu_profiler_get_timings(const GpuZoneTiming **timings);
+
+class GpuProfileZone {
+public:
+  // `name` must be a string literal, only the pointer is stored
+  GpuProfileZone(Context *context, VkCommandBuffer commandBuffer, CString name)
+      : _context(context), _commandBuffer(commandBuffer),
+        _zone(gpu_profiler_begin(context, commandBuffer, name)) {}
+  ~GpuProfileZone() { gpu_profiler_end(_context, _commandBuffer, _zone); }
+
+  GpuProfileZone(const GpuProfileZone &)            = delete;
+  GpuProfileZone &operator=(const GpuProfileZone &) = delete;
+
+private:
+  Context        *_context;
+  VkCommandBuffer _commandBuffer;
+  u32             _zone;
+};
+
+// Times the commands recorded in the enclosing scope on the GPU
+#define GPU_PROFILE_SCOPE(context, commandBuffer, name)                                            \
+  GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(context, commandBuffer, name)
@@ -141,14 +141,20 @@ bool graphics_pipeline_create(Context                           *context,
   pipelineCreateInfo.layout              = out->layout;
   pipelineCreateInfo.renderPass          = renderPass->handle;
 
-  VK_CHECK(vkCreateGraphicsPipelines(context->device.handle,
-                                     VK_NULL_HANDLE,
-                                     1,
-                                     &pipelineCreateInfo,
-                                     context->allocator,
-                                     &out->handle));
-
-  LOG_DEBUG("Graphics pipeline created");
+  VkResult result = vkCreateGraphicsPipelines(context->device.handle,
+                                              VK_NULL_HANDLE,
+                                              1,
+                                              &pipelineCreateInfo,
+                                              context->allocator,
+                                              &out->handle);
+  if (result != VK_SUCCESS) { // E.g. a reloaded shader the driver rejects
+    LOGC_ERROR(Renderer, "Failed to create graphics pipeline: %d", result);
+    vkDestroyPipelineLayout(context->device.handle, out->layout, context->allocator);
+    *out = {};
+    return false;
+  }
+
+  LOGC_DEBUG(Renderer, "Graphics pipeline created");
 
   return true;
 }
@@ -0,0 +1,178 @@
+//
+// Created by Hongjian Zhu on 2022/10/31.
+//
+
+#include "renderer/ShaderReloader.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include "event.h"
+#include "logging.h"
+#include "platform/file_watcher.h"
+#include "renderer/Pipeline.h"
+#include "renderer/shaders/ObjectShader.h"
+#include <atomic>
+#include <cstring>
+#include <new>
+
+static constexpr u32 RETIRED_CAPACITY = 8;
+
+struct ReloadJob {
+  Context          *context;
+  u32               stageMask;                          // Stages to rebuild
+  ShaderStage       stages[OBJECT_SHADER_STATE_COUNT];  // The ones in use when the job started
+  ShaderStage       rebuilt[OBJECT_SHADER_STATE_COUNT]; // Set for the stages in `stageMask`
+  Pipeline          pipeline;
+  bool              succeeded;
+  std::atomic<bool> done;
+};
+
+// Replaced objects waiting for the frames recorded with them to finish
+struct Retired {
+  u32         stageMask;
+  ShaderStage stages[OBJECT_SHADER_STATE_COUNT];
+  Pipeline    pipeline;
+  u64         frameNumber; // When it was replaced
+};
+
+struct ShaderReloaderState {
+  ThreadPool worker; // A single thread, reloads are rare
+  ReloadJob  job;
+  bool       jobRunning;
+  u32        changedStages; // Waiting for the next job
+  Retired    retired[RETIRED_CAPACITY];
+  u32        retiredCount;
+};
+
+static ShaderReloaderState *state = nullptr;
+
+static bool on_file_changed(EventCode           code,
+                            void               *sender,
+                            void               *listener,
+                            const EventContext &context) {
+  i32 stage = object_shader_find_stage(file_watcher_get_path(context.u32[0]));
+  if (stage >= 0) { state->changedStages |= 1u << stage; }
+  return false; // Others may be interested in the same file
+}
+
+static void rebuild(void *data) {
+  PROFILE_SCOPE("shader_reload");
+  auto job     = (ReloadJob *) data;
+  auto context = job->context;
+
+  ShaderStage stages[OBJECT_SHADER_STATE_COUNT];
+  u32         built = 0;
+  bool        ok    = true;
+  for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+    stages[i] = job->stages[i];
+    if (!(job->stageMask & (1u << i))) { continue; }
+    ok = ok && object_shader_create_stage(context, i, &job->rebuilt[i]);
+    if (!ok) { break; }
+    built |= 1u << i;
+    stages[i] = job->rebuilt[i];
+  }
+  ok = ok && object_shader_create_pipeline(context, &context->objectShader, stages, &job->pipeline);
+
+  if (!ok) {
+    for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+      if (!(built & (1u << i))) { continue; }
+      vkDestroyShaderModule(context->device.handle, job->rebuilt[i].module, context->allocator);
+    }
+  }
+  job->succeeded = ok;
+  job->done.store(true, std::memory_order_release);
+}
+
+static void destroy_retired(Context *context, Retired &retired) {
+  pipeline_destroy(context, &retired.pipeline);
+  for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+    if (!(retired.stageMask & (1u << i))) { continue; }
+    vkDestroyShaderModule(context->device.handle, retired.stages[i].module, context->allocator);
+  }
+}
+
+static void retire(Context *context, const Retired &retired) {
+  if (state->retiredCount == RETIRED_CAPACITY) { // Reloading faster than frames complete
+    vkDeviceWaitIdle(context->device.handle);
+    for (u32 i = 0; i < state->retiredCount; ++i) {
+      destroy_retired(context, state->retired[i]);
+    }
+    state->retiredCount = 0;
+  }
+  state->retired[state->retiredCount++] = retired;
+}
+
+// Installs the rebuilt objects, the frame being recorded is the first to use them
+static void swap(Context *context) {
+  auto   &job    = state->job;
+  auto   &shader = context->objectShader;
+  Retired retired{.stageMask = job.stageMask, .pipeline = shader.pipeline};
+  retired.frameNumber = context->frameNumber;
+  for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+    if (!(job.stageMask & (1u << i))) { continue; }
+    retired.stages[i] = shader.stages[i];
+    shader.stages[i]  = job.rebuilt[i];
+  }
+  shader.pipeline = job.pipeline;
+  retire(context, retired);
+}
+
+void shader_reloader_initialize(u64 *memorySize, void *pState, Context *context) {
+  *memorySize = sizeof(ShaderReloaderState);
+  if (!pState) { return; }
+  state = new (pState) ShaderReloaderState();
+  state->worker.start(1);
+  event_register(EventCode::FileChanged, nullptr, on_file_changed);
+}
+
+void shader_reloader_shutdown(Context *context) {
+  if (!state) { return; }
+  event_deregister(EventCode::FileChanged, nullptr, on_file_changed);
+  state->worker.stop(); // Lets a running job finish
+  if (state->jobRunning && state->job.succeeded) {
+    // Never swapped in, no frame used it
+    Retired unused{.stageMask = state->job.stageMask, .pipeline = state->job.pipeline};
+    memcpy(unused.stages, state->job.rebuilt, sizeof(unused.stages));
+    destroy_retired(context, unused);
+  }
+  for (u32 i = 0; i < state->retiredCount; ++i) {
+    destroy_retired(context, state->retired[i]);
+  }
+  state->~ShaderReloaderState();
+  state = nullptr;
+}
+
+void shader_reloader_update(Context *context) {
+  if (!state) { return; }
+  // Every frame recorded before the replacement has had its fence waited on
+  u32 kept = 0;
+  for (u32 i = 0; i < state->retiredCount; ++i) {
+    auto &retired = state->retired[i];
+    if (context->frameNumber >= retired.frameNumber + context->swapchain.maxFramesInFlight) {
+      destroy_retired(context, retired);
+    } else {
+      state->retired[kept++] = retired;
+    }
+  }
+  state->retiredCount = kept;
+
+  auto &job = state->job;
+  if (state->jobRunning && job.done.load(std::memory_order_acquire)) {
+    state->jobRunning = false;
+    if (job.succeeded) {
+      swap(context);
+      LOGC_INFO(Renderer, "[ShaderReloader] Reloaded the object shader");
+    } else {
+      LOGC_WARN(Renderer, "[ShaderReloader] Reload failed, keeping the previous object shader");
+    }
+  }
+
+  if (state->jobRunning || state->changedStages == 0) { return; }
+  job.context   = context;
+  job.stageMask = state->changedStages;
+  job.succeeded = false;
+  job.done.store(false, std::memory_order_relaxed);
+  memcpy(job.stages, context->objectShader.stages, sizeof(job.stages));
+  state->changedStages = 0;
+  state->jobRunning    = true;
+  state->worker.submit(rebuild, &job);
+}
@@ -0,0 +1,17 @@
+//
+// Created by Hongjian Zhu on 2022/10/31.
+//
+
+#pragma once
+
+#include "renderer/types.h"
+
+// Rebuilds the stages of the object shader whose assets changed, see EventCode::FileChanged,
+// along with its pipeline on a background thread. The rebuilt objects are swapped in at the next
+// frame boundary, the ones they replace are destroyed once no frame in flight uses them. Only
+// created with hot reload.
+void shader_reloader_initialize(u64 *memorySize, void *pState, Context *context);
+void shader_reloader_shutdown(Context *context);
+
+// Called at the start of a frame, once its fence has been waited on
+void shader_reloader_update(Context *context);
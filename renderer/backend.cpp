@@ -4,6 +4,7 @@
 
 #include "renderer/backend.h"
 #include "container/darray.h"
+#include "core/Profiler.h"
 #include "logging.h"
 #include "math/types.h"
 #include "memory.h"
@@ -12,6 +13,8 @@
 #include "renderer/device.h"
 #include "renderer/fence.h"
 #include "renderer/framebuffer.h"
+#include "renderer/GpuProfiler.h"
+#include "renderer/ShaderReloader.h"
 #include "renderer/render_pass.h"
 #include "renderer/shaders/ObjectShader.h"
 #include "renderer/swapchain.h"
@@ -21,10 +24,15 @@
 
 static Context context{};
 
+// GPU zones spanning begin_frame to end_frame
+static u32 gpuFrameZone;
+static u32 gpuMainPassZone;
+
 u32 cachedFramebufferWidth  = 0;
 u32 cachedFramebufferHeight = 0;
 
-bool initialize(RendererBackend *backend, const char *appName, u32 width, u32 height);
+bool initialize(
+    RendererBackend *backend, const char *appName, u32 width, u32 height, bool hotReload);
 bool shutdown(RendererBackend *backend);
 bool begin_frame(RendererBackend *backend, f32 deltaTime);
 void update_global_state(const glm::mat4 &proj,
@@ -73,7 +81,8 @@ void renderer_backend_cleanup(RendererBackend *backend) {
 
 // ------- Vulkan implementations -------
 
-bool initialize(RendererBackend *backend, const char *appName, u32 width, u32 height) {
+bool initialize(
+    RendererBackend *backend, const char *appName, u32 width, u32 height, bool hotReload) {
   context.query_memory_type_index = query_memory_type_index;
 
   cachedFramebufferWidth = width, cachedFramebufferHeight = height;
@@ -95,9 +104,9 @@ bool initialize(RendererBackend *backend, const char *appName, u32 width, u32 he
 #ifdef DEBUG
   DARRAY_PUSH(requiredExtensions, &VK_EXT_DEBUG_UTILS_EXTENSION_NAME); // Debug utilities
 
-  LOG_DEBUG("Required instance extensions:");
+  LOGC_DEBUG(Renderer, "Required instance extensions:");
   for (u32 i = 0; i < darray_length(requiredExtensions); ++i) {
-    LOG_DEBUG("  %s", requiredExtensions[i]);
+    LOGC_DEBUG(Renderer, "  %s", requiredExtensions[i]);
   }
 #endif
 
@@ -186,6 +195,17 @@ bool initialize(RendererBackend *backend, const char *appName, u32 width, u32 he
 
   // Create builtin shaders
   ASSERT(object_shader_create(&context, &context.objectShader));
+  if (hotReload) {
+    shader_reloader_initialize(&context.shaderReloaderMemorySize, nullptr, &context);
+    context.shaderReloaderState =
+        memory_allocate(context.shaderReloaderMemorySize, MemoryTag::Renderer);
+    shader_reloader_initialize(
+        &context.shaderReloaderMemorySize, context.shaderReloaderState, &context);
+  }
+
+  gpu_profiler_initialize(&context.gpuProfilerMemorySize, nullptr, &context);
+  context.gpuProfilerState = memory_allocate(context.gpuProfilerMemorySize, MemoryTag::Renderer);
+  gpu_profiler_initialize(&context.gpuProfilerMemorySize, context.gpuProfilerState, &context);
 
   create_buffers(&context);
 
@@ -238,6 +258,13 @@ bool shutdown(RendererBackend *backend) {
   buffer_destroy(&context, &context.objectIndexBuffer);
   buffer_destroy(&context, &context.objectVertexBuffer);
 
+  gpu_profiler_shutdown(&context);
+  memory_free(context.gpuProfilerState, context.gpuProfilerMemorySize, MemoryTag::Renderer);
+  if (context.shaderReloaderState) {
+    shader_reloader_shutdown(&context);
+    memory_free(
+        context.shaderReloaderState, context.shaderReloaderMemorySize, MemoryTag::Renderer);
+  }
   object_shader_destroy(&context, &context.objectShader);
 
   darray_destroy(context.imagesInFlight);
@@ -276,6 +303,7 @@ bool shutdown(RendererBackend *backend) {
 }
 
 bool begin_frame(RendererBackend *backend, f32 deltaTime) {
+  PROFILE_SCOPE("begin_frame");
   auto device = context.device;
   if (context.recreatingSwapchain) {
     VK_CHECK(vkDeviceWaitIdle(device.handle));
@@ -291,6 +319,8 @@ bool begin_frame(RendererBackend *backend, f32 deltaTime) {
   // move on
   assert(fence_wait(&context, &context.inFlightFences[context.currentFrame]));
 
+  shader_reloader_update(&context); // Nothing has been recorded with the shader yet
+
   // Acquire the next image from the swapchain. Pass along the semaphore that should be signaled
   // when completes. The same semaphore will later be waited on by the queue submission to ensure
   // the image is available
@@ -308,6 +338,9 @@ bool begin_frame(RendererBackend *backend, f32 deltaTime) {
 
   command_buffer_begin(commandBuffer, false, false, false);
 
+  gpu_profiler_begin_frame(&context, commandBuffer->handle);
+  gpuFrameZone = gpu_profiler_begin(&context, commandBuffer->handle, "frame");
+
   // Dynamic states
   VkViewport viewport{};
   viewport.x        = 0;
@@ -325,6 +358,7 @@ bool begin_frame(RendererBackend *backend, f32 deltaTime) {
   vkCmdSetViewport(commandBuffer->handle, 0, 1, &viewport);
   vkCmdSetScissor(commandBuffer->handle, 0, 1, &scissor);
 
+  gpuMainPassZone = gpu_profiler_begin(&context, commandBuffer->handle, "main_pass");
   render_pass_begin(commandBuffer,
                     &context.mainRenderPass,
                     context.swapchain.framebuffers[context.imageIndex].handle);
@@ -348,10 +382,13 @@ void update_global_state(const glm::mat4 &proj,
 }
 
 bool end_frame(RendererBackend *backend, f32 deltaTime) {
+  PROFILE_SCOPE("end_frame");
   auto commandBuffer = &(context.graphicsCommandBuffers[context.imageIndex]);
 
   render_pass_end(commandBuffer, &context.mainRenderPass);
+  gpu_profiler_end(&context, commandBuffer->handle, gpuMainPassZone);
 
+  gpu_profiler_end(&context, commandBuffer->handle, gpuFrameZone);
   command_buffer_end(commandBuffer);
 
   // Make sure the previous frame is not using this image (i.e. its fence is being waited on)
@@ -391,6 +428,7 @@ bool end_frame(RendererBackend *backend, f32 deltaTime) {
                          context.inFlightFences[context.currentFrame].handle));
 
   command_buffer_update_submitted(commandBuffer);
+  context.frameNumber++;
 
   // Give the image back to the swapchain
   swapchain_present(&context,
@@ -533,6 +571,7 @@ void upload_data(Context      *context,
 }
 
 void update_object(const glm::mat4 &model) {
+  PROFILE_SCOPE("update_object");
   auto commandBuffer = context.graphicsCommandBuffers[context.imageIndex].handle;
 
   object_shader_update_object(&context, &context.objectShader, model);
@@ -547,7 +586,10 @@ void update_object(const glm::mat4 &model) {
   // Bind index buffer at offset
   vkCmdBindIndexBuffer(commandBuffer, context.objectIndexBuffer.handle, 0, VK_INDEX_TYPE_UINT32);
   // Issue the draw
-  vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
+  {
+    GPU_PROFILE_SCOPE(&context, commandBuffer, "draw_object");
+    vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
+  }
   // Todo End temp code
 }
 
@@ -559,16 +601,16 @@ debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
   switch (messageSeverity) {
   default:
   case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-    LOG_ERROR(pCallbackData->pMessage);
+    LOGC_ERROR(Renderer, "%s", pCallbackData->pMessage);
     break;
   case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-    LOG_WARN(pCallbackData->pMessage);
+    LOGC_WARN(Renderer, "%s", pCallbackData->pMessage);
     break;
   case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-    LOG_INFO(pCallbackData->pMessage);
+    LOGC_INFO(Renderer, "%s", pCallbackData->pMessage);
     break;
   case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-    LOG_DEBUG(pCallbackData->pMessage);
+    LOGC_DEBUG(Renderer, "%s", pCallbackData->pMessage);
     break;
   }
   return VK_FALSE;
@@ -11,7 +11,8 @@
 struct Context;
 
 struct RendererBackend {
-  bool (*initialize)(RendererBackend *backend, const char *appName, u32 width, u32 height);
+  bool (*initialize)(
+      RendererBackend *backend, const char *appName, u32 width, u32 height, bool hotReload);
   bool (*shutdown)(RendererBackend *backend);
   void (*resize)(RendererBackend *backend, u16 width, u16 height);
   bool (*beginFrame)(RendererBackend *backend, f32 deltaTime);
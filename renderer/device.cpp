@@ -7,6 +7,7 @@
 #include "defines.h"
 #include "memory.h"
 #include "renderer/types.h"
+#include <cstring>
 
 void select_physical_device(Context *context);
 
@@ -23,14 +24,22 @@ void device_create(Context *context) {
   };
   f32 queuePriority = 1.0f;
 
+  // Families may be shared, each one is only created once
   VkDeviceQueueCreateInfo queueCreateInfos[4];
+  u32                     queueCreateInfoCount = 0;
   for (u32 i = 0; i < 4; ++i) {
-    queueCreateInfos[i].sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfos[i].queueFamilyIndex = indices[i];
-    queueCreateInfos[i].queueCount       = 1;
-    queueCreateInfos[i].pQueuePriorities = &queuePriority;
-    queueCreateInfos[i].pNext            = nullptr;
-    queueCreateInfos[i].flags            = 0;
+    bool created = false;
+    for (u32 j = 0; j < queueCreateInfoCount; ++j) {
+      if (queueCreateInfos[j].queueFamilyIndex == indices[i]) { created = true; }
+    }
+    if (created) { continue; }
+    auto &queueCreateInfo            = queueCreateInfos[queueCreateInfoCount++];
+    queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo.queueFamilyIndex = indices[i];
+    queueCreateInfo.queueCount       = 1;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+    queueCreateInfo.pNext            = nullptr;
+    queueCreateInfo.flags            = 0;
   }
 
   // Request features
@@ -39,10 +48,27 @@ void device_create(Context *context) {
 
   auto requiredExtensions = DARRAY_CREATE_TAG(CString, MemoryTag::Renderer);
   DARRAY_PUSH(requiredExtensions, &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
-  DARRAY_PUSH(requiredExtensions, &"VK_KHR_portability_subset");
+
+  u32 extensionCount = 0;
+  VK_CHECK(vkEnumerateDeviceExtensionProperties(
+      device.physicalDevice, nullptr, &extensionCount, nullptr));
+  VkExtensionProperties extensions[extensionCount];
+  VK_CHECK(vkEnumerateDeviceExtensionProperties(
+      device.physicalDevice, nullptr, &extensionCount, extensions));
+  for (u32 i = 0; i < extensionCount; ++i) {
+    // Must be enabled where present, e.g. on MoltenVK
+    if (strcmp(extensions[i].extensionName, "VK_KHR_portability_subset") == 0) {
+      DARRAY_PUSH(requiredExtensions, &"VK_KHR_portability_subset");
+    }
+    // Optional, lines GPU timestamps up with the CPU clock
+    if (strcmp(extensions[i].extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
+      DARRAY_PUSH(requiredExtensions, &VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+      device.calibratedTimestamps = true;
+    }
+  }
 
   VkDeviceCreateInfo deviceCreateInfo      = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
-  deviceCreateInfo.queueCreateInfoCount    = 4;
+  deviceCreateInfo.queueCreateInfoCount    = queueCreateInfoCount;
   deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos;
   deviceCreateInfo.pEnabledFeatures        = &features;
   deviceCreateInfo.enabledExtensionCount   = darray_length(requiredExtensions);
@@ -152,6 +178,22 @@ void select_physical_device(Context *context) {
       break; // All queue families are fulfilled
     }
   }
+  // Devices without dedicated families, e.g. software rasterizers, share the graphics one
+  if (graphicsQueueFamily != UINT32_MAX) {
+    auto     flags          = queueFamilies[graphicsQueueFamily].queueFlags;
+    VkBool32 supportPresent = VK_FALSE;
+    VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(
+        physicalDevice, graphicsQueueFamily, context->surface, &supportPresent));
+    if (presentQueueFamily == UINT32_MAX && supportPresent == VK_TRUE) {
+      presentQueueFamily = graphicsQueueFamily;
+    }
+    if (computeQueueFamily == UINT32_MAX && flags & VK_QUEUE_COMPUTE_BIT) {
+      computeQueueFamily = graphicsQueueFamily;
+    }
+    if (transferQueueFamily == UINT32_MAX) {
+      transferQueueFamily = graphicsQueueFamily; // Graphics implies transfer
+    }
+  }
   ASSERT(graphicsQueueFamily != UINT32_MAX && presentQueueFamily != UINT32_MAX &&
          computeQueueFamily != UINT32_MAX && transferQueueFamily != UINT32_MAX);
 
@@ -165,6 +207,7 @@ void select_physical_device(Context *context) {
   context->device.presentQueueFamily  = presentQueueFamily;
   context->device.computeQueueFamily  = computeQueueFamily;
   context->device.transferQueueFamily = transferQueueFamily;
+  context->device.timestampValidBits  = queueFamilies[graphicsQueueFamily].timestampValidBits;
 }
 
 bool device_detect_depth_format(Device *device) {
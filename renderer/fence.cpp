@@ -3,6 +3,8 @@
 //
 
 #include "fence.h"
+#include "core/FrameStats.h"
+#include "core/Profiler.h"
 
 void fence_create(Context *context, bool isSignaled, Fence *outFence) {
   VkFenceCreateInfo createInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
@@ -20,6 +22,8 @@ void fence_destroy(Context *context, Fence *fence) {
 }
 
 bool fence_wait(Context *context, Fence *fence, u64 timeoutNs) {
+  PROFILE_SCOPE("fence_wait");
+  FrameStatsTimer frameStatsTimer(FrameMetric::PresentWait);
   if (fence->isSignaled) { return true; }
   auto result = vkWaitForFences(context->device.handle, 1, &fence->handle, true, timeoutNs);
   if (result == VK_SUCCESS) {
@@ -4,9 +4,12 @@
 
 #include "frontend.h"
 #include "backend.h"
+#include "core/Profiler.h"
+#include "input.h"
 #include "logging.h"
 #include "math/types.h"
 #include "memory.h"
+#include "platform.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
 
@@ -16,16 +19,18 @@ struct RenderSystemState {
 
 static RenderSystemState *state = nullptr;
 
+static const f32 LOOK_ANGLE = glm::radians(15.0f);
+
 bool begin_frame(f32 deltaTime);
 bool end_frame(f32 deltaTime);
 
 bool renderer_system_initialize(
-    u64 *memorySize, void *pState, CString appName, u32 width, u32 height) {
+    u64 *memorySize, void *pState, CString appName, u32 width, u32 height, bool hotReload) {
   *memorySize = sizeof(RenderSystemState);
   if (!pState) { return true; }
   state = (RenderSystemState *) pState;
   renderer_backend_setup(&state->backend);
-  return state->backend.initialize(&state->backend, appName, width, height);
+  return state->backend.initialize(&state->backend, appName, width, height, hotReload);
 }
 
 void renderer_system_shutdown() {
@@ -34,17 +39,34 @@ void renderer_system_shutdown() {
 }
 
 bool renderer_draw_frame(const RenderPacket &packet) {
+  PROFILE_SCOPE("draw_frame");
   if (begin_frame(packet.deltaTime)) {
+    // begin_frame may have blocked on the swapchain, pick up where the cursor went meanwhile
+    if (packet.lateLatchInput) { input_late_latch(); }
+
     const auto proj = glm::perspective(glm::radians(45.0f), 480.0f / 480.0f, 0.1f, 100.0f);
 
-    static f32 z = -1.0f;
-    z -= 0.005f;
-    const auto view = glm::translate(glm::mat4(1.0f), {0, 0, z});
+    // Ticks rarely line up with frames, blend the last two so motion stays smooth
+    f32 z     = glm::mix(packet.previousScene.cameraZ, packet.scene.cameraZ, packet.alpha);
+    f32 angle = glm::mix(packet.previousScene.angle, packet.scene.angle, packet.alpha);
+
+    // Only when late latching, the camera turns with the latched cursor, up to LOOK_ANGLE to
+    // either side of the window's center. Otherwise the scene stays as it always was.
+    f32 yaw = 0;
+    if (packet.lateLatchInput) {
+      f32 mouseX = 0, mouseY = 0;
+      u32 windowWidth = 0, windowHeight = 0;
+      input_get_latched_mouse_position(mouseX, mouseY);
+      platform_get_window_size(windowWidth, windowHeight);
+      if (windowWidth) {
+        yaw = glm::clamp(mouseX / (f32) windowWidth * 2 - 1, -1.0f, 1.0f) * LOOK_ANGLE;
+      }
+    }
+    const auto view = glm::rotate(glm::mat4(1.0f), yaw, {0, 1, 0}) *
+                      glm::translate(glm::mat4(1.0f), {0, 0, z});
 
     state->backend.updateGlobalState(proj, view, VEC3_ZERO, VEC4_ONE, 0);
 
-    static float angle = 0.0f;
-    angle += 0.01f;
     auto quat  = glm::angleAxis(angle, glm::vec3(0, 0, 1));
     auto model = glm::mat4_cast(quat);
     state->backend.updateObject(model);
@@ -60,7 +82,7 @@ void rendererOnResize(u16 width, u16 height) {
   if (state) {
     state->backend.resize(&state->backend, width, height);
   } else {
-    LOG_WARN("Renderer backend does not exist to accept size: %i %i", width, height);
+    LOGC_WARN(Renderer, "Renderer backend does not exist to accept size: %i %i", width, height);
   }
 }
 
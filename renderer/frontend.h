@@ -7,12 +7,23 @@
 
 #include "defines.h"
 
+// What the simulation ticks advance, the renderer only ever reads it
+struct SceneState {
+  f32 cameraZ;
+  f32 angle;
+};
+
 struct RenderPacket {
-  f32 deltaTime;
+  f32        deltaTime;
+  f32        alpha; // Between the previous and the latest tick, to interpolate their scenes
+  SceneState previousScene;
+  SceneState scene;
+  bool       lateLatchInput; // Re-sample the cursor right before the view matrices are built
 };
 
+// `hotReload` rebuilds the shaders when their assets change, see ShaderReloader.h
 bool renderer_system_initialize(
-    u64 *memorySize, void *pState, CString appName, u32 width, u32 height);
+    u64 *memorySize, void *pState, CString appName, u32 width, u32 height, bool hotReload);
 void renderer_system_shutdown();
 
 bool renderer_draw_frame(const RenderPacket &packet);
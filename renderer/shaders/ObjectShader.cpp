@@ -4,6 +4,7 @@
 
 #include "ObjectShader.h"
 #include "StringUtils.h"
+#include "core/Assets.h"
 #include "logging.h"
 #include "math/types.h"
 #include "memory.h"
@@ -11,16 +12,20 @@
 #include "renderer/Pipeline.h"
 #include "renderer/buffer.h"
 #include <array>
+#include <cstring>
 
-bool create_shader_module(Context *context, CString name, CString type, ShaderStage *out);
+static const VkShaderStageFlagBits stageFlags[OBJECT_SHADER_STATE_COUNT] = {
+    VK_SHADER_STAGE_VERTEX_BIT,
+    VK_SHADER_STAGE_FRAGMENT_BIT,
+};
+static const char stageTypes[OBJECT_SHADER_STATE_COUNT][5] = {"vert", "frag"};
+
+static bool create_shader_module(Context *context, CString name, CString type, ShaderStage *out);
 
 bool object_shader_create(Context *context, ObjectShader *out) {
   // Shader module init per stage
-  const char types[OBJECT_SHADER_STATE_COUNT][5] = {"vert", "frag"};
   for (u8 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
-    if (!create_shader_module(context, "Builtin.ObjectShader", types[i], &out->stages[i])) {
-      return false;
-    }
+    if (!object_shader_create_stage(context, i, &out->stages[i])) { return false; }
   }
 
   // Descriptors
@@ -50,66 +55,8 @@ bool object_shader_create(Context *context, ObjectShader *out) {
         context->device.handle, &pool, context->allocator, &out->globalDescriptorPool));
   }
 
-  // Pipeline creation
-  VkViewport viewport{};
-  viewport.x        = 0;
-  viewport.y        = (f32) context->framebufferHeight;
-  viewport.width    = (f32) context->framebufferWidth;
-  viewport.height   = -(f32) context->framebufferHeight;
-  viewport.minDepth = 0;
-  viewport.maxDepth = 1;
-
-  VkRect2D scissor{};
-  scissor.offset.x = scissor.offset.y = 0;
-  scissor.extent.width                = context->framebufferWidth;
-  scissor.extent.height               = context->framebufferHeight;
-
-  // Attributes
-  const u32                         attributeCount = 2;
-  VkVertexInputAttributeDescription attributeDescriptions[attributeCount];
-
-  // Position and color
-  VkFormat formats[attributeCount] = {VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT};
-  u32      offsets[attributeCount] = {offsetof(Vertex3D, position), offsetof(Vertex3D, color)};
-  for (u32 i = 0; i < attributeCount; ++i) {
-    attributeDescriptions[i].binding  = 0; // Binding index - should match binding desc
-    attributeDescriptions[i].location = i; // Attribute location
-    attributeDescriptions[i].format   = formats[i];
-    attributeDescriptions[i].offset   = offsets[i];
-  }
-
-  // Descriptor set layouts
-  const u32             descriptorSetLayoutCount          = 1;
-  VkDescriptorSetLayout layouts[descriptorSetLayoutCount] = {
-      out->globalDescriptorSetLayout,
-  };
-
-  // Stages
-  std::array<VkPipelineShaderStageCreateInfo, OBJECT_SHADER_STATE_COUNT> stageCreateInfos{};
-  const VkShaderStageFlagBits stages[OBJECT_SHADER_STATE_COUNT] = {
-      VK_SHADER_STAGE_VERTEX_BIT,
-      VK_SHADER_STAGE_FRAGMENT_BIT,
-  };
-  for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
-    stageCreateInfos[i].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stageCreateInfos[i].stage  = stages[i];
-    stageCreateInfos[i].module = out->stages[i].module;
-    stageCreateInfos[i].pName  = "main";
-  }
-
-  if (!graphics_pipeline_create(context,
-                                &context->mainRenderPass,
-                                attributeCount,
-                                attributeDescriptions,
-                                descriptorSetLayoutCount,
-                                layouts,
-                                OBJECT_SHADER_STATE_COUNT,
-                                stageCreateInfos.data(),
-                                viewport,
-                                scissor,
-                                false,
-                                &out->pipeline)) {
-    LOG_ERROR("Failed to create graphics pipeline for object shader");
+  if (!object_shader_create_pipeline(context, out, out->stages, &out->pipeline)) {
+    LOGC_ERROR(Renderer, "Failed to create graphics pipeline for object shader");
     return false;
   }
 
@@ -212,29 +159,112 @@ void object_shader_update_object(Context *context, ObjectShader *shader, const g
                      &model);
 }
 
-bool create_shader_module(Context *context, CString name, CString type, ShaderStage *out) {
-  // Build file path
-  char filepath[512];
-  utils::string_format(filepath, "assets/shaders/%s.%s.spv", name, type);
+bool object_shader_create_pipeline(Context           *context,
+                                   ObjectShader      *shader,
+                                   const ShaderStage *stages,
+                                   Pipeline          *out) {
+  VkViewport viewport{};
+  viewport.x        = 0;
+  viewport.y        = (f32) context->framebufferHeight;
+  viewport.width    = (f32) context->framebufferWidth;
+  viewport.height   = -(f32) context->framebufferHeight;
+  viewport.minDepth = 0;
+  viewport.maxDepth = 1;
+
+  VkRect2D scissor{};
+  scissor.offset.x = scissor.offset.y = 0;
+  scissor.extent.width                = context->framebufferWidth;
+  scissor.extent.height               = context->framebufferHeight;
 
-  FileHandle handle{};
-  if (!filesystem_open(filepath, FILE_MODE_READ, true, &handle)) { return false; }
+  // Attributes
+  const u32                         attributeCount = 2;
+  VkVertexInputAttributeDescription attributeDescriptions[attributeCount];
 
-  // Read the entire file as binary
-  u8 *buffer = nullptr;
-  u64 size   = 0;
-  if (!filesystem_read_all(&handle, &buffer, &size)) { return false; }
+  // Position and color
+  VkFormat formats[attributeCount] = {VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT};
+  u32      offsets[attributeCount] = {offsetof(Vertex3D, position), offsetof(Vertex3D, color)};
+  for (u32 i = 0; i < attributeCount; ++i) {
+    attributeDescriptions[i].binding  = 0; // Binding index - should match binding desc
+    attributeDescriptions[i].location = i; // Attribute location
+    attributeDescriptions[i].format   = formats[i];
+    attributeDescriptions[i].offset   = offsets[i];
+  }
 
-  VkShaderModuleCreateInfo shaderModuleCreateInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-  shaderModuleCreateInfo.codeSize                 = size;
-  shaderModuleCreateInfo.pCode                    = (u32 *) buffer;
+  // Descriptor set layouts
+  const u32             descriptorSetLayoutCount          = 1;
+  VkDescriptorSetLayout layouts[descriptorSetLayoutCount] = {
+      shader->globalDescriptorSetLayout,
+  };
+
+  // Stages
+  std::array<VkPipelineShaderStageCreateInfo, OBJECT_SHADER_STATE_COUNT> stageCreateInfos{};
+  for (u32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+    stageCreateInfos[i].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageCreateInfos[i].stage  = stageFlags[i];
+    stageCreateInfos[i].module = stages[i].module;
+    stageCreateInfos[i].pName  = "main";
+  }
+
+  return graphics_pipeline_create(context,
+                                  &context->mainRenderPass,
+                                  attributeCount,
+                                  attributeDescriptions,
+                                  descriptorSetLayoutCount,
+                                  layouts,
+                                  OBJECT_SHADER_STATE_COUNT,
+                                  stageCreateInfos.data(),
+                                  viewport,
+                                  scissor,
+                                  false,
+                                  out);
+}
 
-  VK_CHECK(vkCreateShaderModule(
-      context->device.handle, &shaderModuleCreateInfo, context->allocator, &out->module));
+bool object_shader_create_stage(Context *context, u32 stage, ShaderStage *out) {
+  return create_shader_module(context, "Builtin.ObjectShader", stageTypes[stage], out);
+}
 
-  memory_free(buffer, sizeof(u8) * size, MemoryTag::STRING);
+i32 object_shader_find_stage(CString assetName) {
+  for (i32 i = 0; i < OBJECT_SHADER_STATE_COUNT; ++i) {
+    char name[512];
+    utils::string_format(name, "shaders/Builtin.ObjectShader.%s.spv", stageTypes[i]);
+    if (strcmp(name, assetName) == 0) { return i; }
+  }
+  return -1;
+}
 
-  filesystem_close(&handle);
+static bool create_shader_module(Context     *context,
+                                 CString      name,
+                                 CString      type,
+                                 ShaderStage *out) {
+  char assetName[512];
+  utils::string_format(assetName, "shaders/%s.%s.spv", name, type);
+
+  // Usually decompressed into a heap buffer, malloc's alignment satisfies SPIR-V's 4 bytes. Stored
+  // archive blobs and loose files are mapped, page aligned.
+  Asset asset{};
+  if (!asset_load(assetName, &asset) || asset.size == 0) {
+    LOGC_ERROR(Renderer, "Failed to load shader '%s'", assetName);
+    asset_release(&asset);
+    return false;
+  }
+  // Reloaded files may be half written or not compiled at all
+  const u32 spirvMagic = 0x07230203;
+  if (asset.size % 4 != 0 || *(const u32 *) asset.data != spirvMagic) {
+    LOGC_ERROR(Renderer, "Shader '%s' is not SPIR-V", assetName);
+    asset_release(&asset);
+    return false;
+  }
 
+  VkShaderModuleCreateInfo shaderModuleCreateInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+  shaderModuleCreateInfo.codeSize                 = asset.size;
+  shaderModuleCreateInfo.pCode                    = (const u32 *) asset.data;
+
+  VkResult result = vkCreateShaderModule(
+      context->device.handle, &shaderModuleCreateInfo, context->allocator, &out->module);
+  asset_release(&asset);
+  if (result != VK_SUCCESS) {
+    LOGC_ERROR(Renderer, "Failed to create shader module for '%s': %d", assetName, result);
+    return false;
+  }
   return true;
 }
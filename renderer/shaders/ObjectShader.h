@@ -15,3 +15,16 @@ void object_shader_use(Context *context, ObjectShader *shader);
 void object_shader_update_global_state(Context *context, ObjectShader *shader);
 
 void object_shader_update_object(Context *context, ObjectShader *shader, const glm::mat4 &model);
+
+// Only reads `shader`'s descriptor set layout, safe to call from another thread while it's in use
+bool object_shader_create_pipeline(Context           *context,
+                                   ObjectShader      *shader,
+                                   const ShaderStage *stages,
+                                   Pipeline          *out);
+
+// Index of the stage loaded from `assetName`, -1 if the shader doesn't use it
+i32 object_shader_find_stage(CString assetName);
+
+// Creates the module of one stage from its current asset. Fails without asserting, so a broken
+// reload keeps the old module.
+bool object_shader_create_stage(Context *context, u32 stage, ShaderStage *out);
@@ -3,6 +3,8 @@
 //
 
 #include "renderer/swapchain.h"
+#include "core/FrameStats.h"
+#include "core/Profiler.h"
 #include "defines.h"
 #include "logging.h"
 #include "memory.h"
@@ -30,6 +32,7 @@ bool swapchain_acquire_next_image(Context    *context,
                                   VkSemaphore imageAvailableSemaphore,
                                   VkFence     fence,
                                   u32        *outImageIndex) {
+  FrameStatsTimer frameStatsTimer(FrameMetric::PresentWait);
   auto result = vkAcquireNextImageKHR(context->device.handle,
                                       swapchain->handle,
                                       timeoutNs,
@@ -40,7 +43,7 @@ bool swapchain_acquire_next_image(Context    *context,
     swapchain_recreate(context, context->framebufferWidth, context->framebufferHeight, swapchain);
     return false; // Boot out of the render loop
   } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-    LOG_ERROR("Failed to acquire swapchain image");
+    LOGC_ERROR(Renderer, "Failed to acquire swapchain image");
     return false;
   }
   return true;
@@ -52,6 +55,8 @@ void swapchain_present(Context    *context,
                        VkQueue     presentQueue,
                        VkSemaphore renderCompleteSemaphore,
                        u32         presentImageIndex) {
+  PROFILE_SCOPE("swapchain_present");
+  FrameStatsTimer frameStatsTimer(FrameMetric::PresentWait);
   // Return the image to the swapchain for presentation
   VkPresentInfoKHR presentInfo   = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
   presentInfo.waitSemaphoreCount = 1;
@@ -65,7 +70,7 @@ void swapchain_present(Context    *context,
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
     swapchain_recreate(context, context->framebufferWidth, context->framebufferHeight, swapchain);
   } else if (result != VK_SUCCESS) {
-    LOG_ERROR("Failed to present swapchain image");
+    LOGC_ERROR(Renderer, "Failed to present swapchain image");
   }
 
   // Increase (and loop) the index
@@ -149,7 +154,7 @@ void create(Context *context, u32 width, u32 height, Swapchain *out) {
   VK_CHECK(vkCreateSwapchainKHR(
       context->device.handle, &swapchainCreateInfo, context->allocator, &out->handle));
 
-  LOG_DEBUG("Swapchain created");
+  LOGC_DEBUG(Renderer, "Swapchain created");
 
   context->currentFrame = 0; // Start with a zero frame index
 
@@ -196,5 +201,5 @@ void destroy(Context *context, Swapchain *swapchain) {
   MEMORY_FREE(swapchain->views, VkImageView, swapchain->imageCount, MemoryTag::ImageView);
   MEMORY_FREE(swapchain->images, VkImage, swapchain->imageCount, MemoryTag::Image);
   vkDestroySwapchainKHR(context->device.handle, swapchain->handle, context->allocator);
-  LOG_DEBUG("Swapchain destroyed");
+  LOGC_DEBUG(Renderer, "Swapchain destroyed");
 }
@@ -56,6 +56,9 @@ struct Device {
   VkCommandPool graphicsCommandPool;
 
   VkFormat depthFormat;
+
+  u32  timestampValidBits;   // Of the graphics queue, 0 if it can't write timestamps
+  bool calibratedTimestamps; // VK_EXT_calibrated_timestamps is enabled
 };
 
 struct Image {
@@ -165,6 +168,7 @@ struct Context {
   Swapchain swapchain;
   u32       imageIndex;
   u64       currentFrame; // [0, Swapchain::maxFramesInFlight - 1]
+  u64       frameNumber;  // Frames submitted so far
   bool      recreatingSwapchain;
 
   ObjectShader objectShader;
@@ -186,6 +190,11 @@ struct Context {
 
   Fence **imagesInFlight; // [0, Swapchain::imageCount - 1]
 
+  u64   shaderReloaderMemorySize;
+  void *shaderReloaderState; // Null without hot reload
+  u64   gpuProfilerMemorySize;
+  void *gpuProfilerState;
+
   bool (*query_memory_type_index)(u32                   requiredType,
                                   VkMemoryPropertyFlags requiredProperty,
                                   u32                  &index);
@@ -0,0 +1,172 @@
+//
+// Created by Hongjian Zhu on 2022/10/29.
+//
+
+// Packs a directory into an asset archive, see core/AssetArchive.h for the layout.
+// Usage: pokemoon_asset_packer [--store] <output.pak> <assets directory>
+// Assets are compressed unless it saves less than an eighth of their size or `--store` is given.
+
+#include "core/AssetArchive.h"
+#include "core/Compression.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct PackedFile {
+  std::string     name; // Relative to the assets directory
+  std::string     path;
+  u64             size;
+  u64             offset;
+  std::vector<u8> stored;
+  u32             flags;
+  u32             chunkCount;
+};
+
+static u64 align_up(u64 value, u64 alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+static bool write_padding(FILE *file, u64 from, u64 to) {
+  static const u8 zeros[ASSET_ARCHIVE_ALIGNMENT] = {};
+  return to == from || fwrite(zeros, 1, to - from, file) == to - from;
+}
+
+static bool read_file(PackedFile &file) {
+  FILE *in = fopen(file.path.c_str(), "rb");
+  file.stored.resize(file.size);
+  bool ok = in && fread(file.stored.data(), 1, file.size, in) == file.size;
+  if (in) { fclose(in); }
+  return ok;
+}
+
+// Replaces the contents with the chunk sizes followed by the chunks if that's worth it
+static void compress_file(PackedFile &file) {
+  u64             chunkSize  = ASSET_ARCHIVE_CHUNK_SIZE;
+  u32             chunkCount = (u32) ((file.size + chunkSize - 1) / chunkSize);
+  std::vector<u8> compressed(chunkCount * sizeof(u32));
+  std::vector<u8> chunk(compress_bound(chunkSize));
+  for (u32 i = 0; i < chunkCount; ++i) {
+    const u8 *src            = file.stored.data() + i * chunkSize;
+    u64       size           = std::min(chunkSize, file.size - i * chunkSize);
+    u64       compressedSize = compress_block(src, size, chunk.data(), chunk.size());
+    if (compressedSize == 0 || compressedSize >= size) { // Stored as is
+      compressedSize = size;
+      memcpy(chunk.data(), src, size);
+    }
+    u32 storedSize = (u32) compressedSize;
+    memcpy(compressed.data() + i * sizeof(u32), &storedSize, sizeof(u32));
+    compressed.insert(compressed.end(), chunk.data(), chunk.data() + compressedSize);
+  }
+  if (compressed.size() > file.size - file.size / 8) { return; }
+  file.stored     = std::move(compressed);
+  file.flags      = ASSET_ARCHIVE_ENTRY_COMPRESSED;
+  file.chunkCount = chunkCount;
+}
+
+int main(int argc, char **argv) {
+  bool compress = !(argc == 4 && strcmp(argv[1], "--store") == 0);
+  if (argc != 3 && compress) {
+    fprintf(stderr, "Usage: %s [--store] <output.pak> <assets directory>\n", argv[0]);
+    return 1;
+  }
+  CString  output = argv[argc - 2];
+  CString  input  = argv[argc - 1];
+  namespace fs    = std::filesystem;
+  fs::path root   = input;
+
+  std::error_code         error;
+  std::vector<PackedFile> files;
+  for (auto it = fs::recursive_directory_iterator(root, error); !error && it != fs::end(it);
+       it.increment(error)) {
+    if (!it->is_regular_file()) { continue; }
+    auto name = fs::relative(it->path(), root).generic_string();
+    files.push_back({name, it->path().string(), (u64) it->file_size(), 0, {}, 0, 0});
+  }
+  if (error) {
+    fprintf(stderr, "Failed to list '%s': %s\n", input, error.message().c_str());
+    return 1;
+  }
+  // Stable output regardless of directory order
+  std::sort(files.begin(), files.end(), [](auto &a, auto &b) { return a.name < b.name; });
+
+  u64 totalSize = 0;
+  for (auto &file : files) {
+    if (!read_file(file)) {
+      fprintf(stderr, "Failed to read '%s'\n", file.path.c_str());
+      return 1;
+    }
+    if (compress && file.size > 0) { compress_file(file); }
+    totalSize += file.size;
+  }
+
+  AssetArchiveHeader header{};
+  memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic));
+  header.version    = ASSET_ARCHIVE_VERSION;
+  header.entryCount = (u32) files.size();
+  header.chunkSize  = ASSET_ARCHIVE_CHUNK_SIZE;
+  header.tableSize  = 1;
+  while (header.tableSize < files.size() * 2) {
+    header.tableSize *= 2;
+  }
+
+  std::string names;
+  for (const auto &file : files) {
+    names += file.name;
+  }
+  header.namesOffset = sizeof(header) + header.tableSize * sizeof(AssetArchiveEntry);
+  header.namesSize   = names.size();
+
+  std::vector<AssetArchiveEntry> table(header.tableSize);
+  u64                            offset     = header.namesOffset + header.namesSize;
+  u32                            nameOffset = 0;
+  for (auto &file : files) {
+    offset      = align_up(offset, ASSET_ARCHIVE_ALIGNMENT);
+    file.offset = offset;
+    offset += file.stored.size();
+
+    u64 hash  = asset_archive_hash(file.name.c_str(), file.name.size());
+    u32 index = (u32) hash & (header.tableSize - 1);
+    while (table[index].hash != 0) {
+      index = (index + 1) & (header.tableSize - 1);
+    }
+    table[index] = {
+        .hash       = hash,
+        .offset     = file.offset,
+        .size       = file.size,
+        .storedSize = file.stored.size(),
+        .nameOffset = nameOffset,
+        .nameLength = (u32) file.name.size(),
+        .flags      = file.flags,
+        .chunkCount = file.chunkCount,
+    };
+    nameOffset += (u32) file.name.size();
+  }
+
+  FILE *out = fopen(output, "wb");
+  if (!out) {
+    fprintf(stderr, "Failed to create '%s'\n", output);
+    return 1;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+            fwrite(table.data(), sizeof(AssetArchiveEntry), table.size(), out) == table.size() &&
+            fwrite(names.data(), 1, names.size(), out) == names.size();
+  u64 position = header.namesOffset + header.namesSize;
+
+  for (const auto &file : files) {
+    if (!ok) { break; }
+    ok = write_padding(out, position, file.offset) &&
+         fwrite(file.stored.data(), 1, file.stored.size(), out) == file.stored.size();
+    if (!ok) { fprintf(stderr, "Failed to pack '%s'\n", file.path.c_str()); }
+    position = file.offset + file.stored.size();
+  }
+  ok = fclose(out) == 0 && ok;
+  if (!ok) {
+    remove(output);
+    return 1;
+  }
+  auto size = (unsigned long long) position;
+  auto raw  = (unsigned long long) totalSize;
+  printf("Packed %zu files into '%s', %llu B from %llu B\n", files.size(), output, size, raw);
+  return 0;
+}
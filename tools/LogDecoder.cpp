@@ -0,0 +1,210 @@
+//
+// Created by Hongjian Zhu on 2022/10/26.
+//
+
+// Turns a binary log (pokemoon.log.bin) back into text.
+// Usage: pokemoon_log_decoder [pokemoon.log.bin] [--time] [--source]
+
+#include "core/BinaryLog.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct FormatEntry {
+  u8          level;
+  u32         line;
+  std::string file;
+  std::string format;
+};
+
+struct Arg {
+  LogArgType  type;
+  u64         bits;
+  std::string string;
+};
+
+static const char *prefixes[6] = {"[Trace]", "[Debug]", "[Info]", "[Warn]", "[Error]", "[Fatal]"};
+
+// Formats one conversion with the captured argument. `spec` is the conversion as written in the
+// format string, its length modifiers are replaced to match the captured type.
+static void format_arg(std::string &out, std::string spec, const Arg *arg) {
+  if (!arg) {
+    out += "<missing>";
+    return;
+  }
+  char conversion = spec.back();
+  spec.pop_back();
+  while (!spec.empty() && strchr("hlLqjzt", spec.back())) {
+    spec.pop_back();
+  }
+
+  char buffer[1024];
+  switch (arg->type) {
+  case LogArgType::String:
+    snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), arg->string.c_str());
+    break;
+  case LogArgType::F64: {
+    f64 value;
+    memcpy(&value, &arg->bits, sizeof(value));
+    if (!strchr("eEfFgGaA", conversion)) { conversion = 'g'; }
+    snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+  } break;
+  case LogArgType::Pointer:
+    snprintf(buffer, sizeof(buffer), (spec + "p").c_str(), (void *) (uintptr_t) arg->bits);
+    break;
+  case LogArgType::I64:
+  case LogArgType::U64:
+    if (conversion == 'c') {
+      snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int) arg->bits);
+    } else if (conversion == 's' || conversion == 'p' || strchr("eEfFgGaA", conversion)) {
+      snprintf(buffer, sizeof(buffer), "%lld", (long long) arg->bits); // Mismatched conversion
+    } else {
+      snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (long long) arg->bits);
+    }
+    break;
+  }
+  out += buffer;
+}
+
+static std::string format_message(const std::string &format, const std::vector<Arg> &args) {
+  std::string out;
+  u64         next = 0;
+  for (u64 i = 0; i < format.size(); ++i) {
+    if (format[i] != '%') {
+      out += format[i];
+      continue;
+    }
+    if (i + 1 < format.size() && format[i + 1] == '%') {
+      out += '%';
+      ++i;
+      continue;
+    }
+    // Flags, width, precision and length up to the conversion character
+    std::string spec = "%";
+    for (++i; i < format.size(); ++i) {
+      char c = format[i];
+      if (c == '*') { // Width/precision taken from the arguments
+        spec += next < args.size() ? std::to_string((i64) args[next++].bits) : "";
+        continue;
+      }
+      spec += c;
+      if (strchr("diouxXeEfFgGaAcspn", c)) { break; }
+    }
+    if (spec.back() == 'n') { continue; }
+    format_arg(out, spec, next < args.size() ? &args[next] : nullptr);
+    ++next;
+  }
+  return out;
+}
+
+static bool decode_payload(const u8 *cursor, const u8 *end, std::vector<Arg> &args) {
+  args.clear();
+  while (cursor < end) {
+    Arg arg{};
+    arg.type = binary_log_get<LogArgType>(cursor);
+    if (arg.type == LogArgType::String) {
+      if (cursor + sizeof(u16) > end) { return false; }
+      auto length = binary_log_get<u16>(cursor);
+      if (cursor + length > end) { return false; }
+      arg.string.assign((const char *) cursor, length);
+      cursor += length;
+    } else {
+      if (cursor + sizeof(u64) > end) { return false; }
+      arg.bits = binary_log_get<u64>(cursor);
+    }
+    args.push_back(std::move(arg));
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *path       = "pokemoon.log.bin";
+  bool        showTime   = false;
+  bool        showSource = false;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--time") == 0) {
+      showTime = true;
+    } else if (strcmp(argv[i], "--source") == 0) {
+      showSource = true;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Failed to open '%s'\n", path);
+    return 1;
+  }
+  std::vector<u8> data;
+  u8              chunk[64 * KiB];
+  for (u64 read; (read = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+    data.insert(data.end(), chunk, chunk + read);
+  }
+  fclose(file);
+
+  BinaryLogHeader header{};
+  if (data.size() < sizeof(header)) {
+    fprintf(stderr, "'%s' is not a binary log\n", path);
+    return 1;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (memcmp(header.magic, BINARY_LOG_MAGIC, 4) != 0 || header.version != BINARY_LOG_VERSION) {
+    fprintf(stderr, "'%s' is not a compatible binary log\n", path);
+    return 1;
+  }
+
+  std::unordered_map<u32, FormatEntry> formats;
+  std::vector<Arg>                     args;
+
+  const u8 *cursor = data.data() + sizeof(header);
+  const u8 *end    = data.data() + data.size();
+  while (cursor < end) {
+    auto kind = binary_log_get<BinaryLogRecord>(cursor);
+    if (kind == BinaryLogRecord::Format) {
+      if (cursor + BINARY_LOG_FORMAT_HEADER - 1 > end) { break; }
+      FormatEntry entry;
+      u32         id = binary_log_get<u32>(cursor);
+      entry.level    = binary_log_get<u8>(cursor);
+      entry.line     = binary_log_get<u32>(cursor);
+      u16 length     = binary_log_get<u16>(cursor);
+      if (cursor + length + sizeof(u16) > end) { break; }
+      entry.file.assign((const char *) cursor, length);
+      cursor += length;
+      length = binary_log_get<u16>(cursor);
+      if (cursor + length > end) { break; }
+      entry.format.assign((const char *) cursor, length);
+      cursor += length;
+      formats[id] = std::move(entry);
+    } else if (kind == BinaryLogRecord::Entry) {
+      if (cursor + BINARY_LOG_ENTRY_HEADER - 1 > end) { break; }
+      u32 id          = binary_log_get<u32>(cursor);
+      u64 timestampNs = binary_log_get<u64>(cursor);
+      u16 size        = binary_log_get<u16>(cursor);
+      if (cursor + size > end) { break; }
+      auto format = formats.find(id);
+      bool ok     = decode_payload(cursor, cursor + size, args);
+      cursor += size;
+      if (format == formats.end() || !ok) {
+        fprintf(stderr, "Corrupted entry (format %u)\n", id);
+        continue;
+      }
+      const auto &entry = format->second;
+      if (showTime) { printf("[%12.6f] ", (f64) timestampNs / 1e9); }
+      printf("%s ", prefixes[entry.level < 6 ? entry.level : 5]);
+      if (showSource) { printf("%s:%u: ", entry.file.c_str(), entry.line); }
+      printf("%s\n", format_message(entry.format, args).c_str());
+    } else {
+      fprintf(stderr, "Unknown record %u, stopping\n", (u32) kind);
+      return 1;
+    }
+  }
+  if (cursor < end) {
+    fprintf(stderr, "Truncated record at the end of '%s'\n", path);
+    return 1;
+  }
+  return 0;
+}